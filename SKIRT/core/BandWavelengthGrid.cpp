@@ -70,15 +70,14 @@ double BandWavelengthGrid::transmission(int ell, double lambda) const
 
 ////////////////////////////////////////////////////////////////////
 
-vector<int> BandWavelengthGrid::bins(double lambda) const
+void BandWavelengthGrid::bins(double lambda, BinList& ellv) const
 {
-    vector<int> result;
+    ellv.clear();
     int n = _bands.size();
     for (int ell = 0; ell != n; ++ell)
     {
-        if (_bands[ell]->wavelengthRange().contains(lambda)) result.push_back(ell);
+        if (_bands[ell]->wavelengthRange().contains(lambda)) ellv.add(ell);
     }
-    return result;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -70,11 +70,11 @@ public:
         formulas. */
     double transmission(int ell, double lambda) const override;
 
-    /** This function returns a list of indices \f$\ell_k\f$ of the bands that may have a nonzero
-        transmission at the specified wavelength \f$\lambda\f$, i.e. for which
+    /** This function stores in the specified list the indices \f$\ell_k\f$ of the bands that may
+        have a nonzero transmission at the specified wavelength \f$\lambda\f$, i.e. for which
         \f$\lambda^\mathrm{left}_\ell \le \lambda \le \lambda^\mathrm{right}_\ell\f$. If no bands
-        match this condition, the function returns an empty list. */
-    vector<int> bins(double lambda) const override;
+        match this condition, the list is left empty. */
+    void bins(double lambda, BinList& ellv) const override;
 
     /** This function returns the index \f$\ell\f$ of a band that may have a nonzero transmission
         at the specified wavelength \f$\lambda\f$, i.e. for which \f$\lambda^\mathrm{left}_\ell \le
@@ -106,6 +106,15 @@ void Configuration::setupSelfBefore()
     _minWeightReduction = ms->photonPacketOptions()->minWeightReduction();
     _minScattEvents = ms->photonPacketOptions()->minScattEvents();
     _pathLengthBias = ms->photonPacketOptions()->pathLengthBias();
+    _rouletteWeightThreshold = ms->photonPacketOptions()->rouletteWeightThreshold();
+    _rouletteSurvivalProbability = ms->photonPacketOptions()->rouletteSurvivalProbability();
+    _splitFactor = ms->photonPacketOptions()->splitFactor();
+    _maxSplitLevels = ms->photonPacketOptions()->maxSplitLevels();
+    _splitRegion = Box(ms->photonPacketOptions()->splitMinX(), ms->photonPacketOptions()->splitMinY(),
+                       ms->photonPacketOptions()->splitMinZ(), ms->photonPacketOptions()->splitMaxX(),
+                       ms->photonPacketOptions()->splitMaxY(), ms->photonPacketOptions()->splitMaxZ());
+    _streamForcedScatteringPaths = ms->photonPacketOptions()->streamForcedScatteringPaths();
+    _peelOffCutoffOpticalDepth = ms->photonPacketOptions()->peelOffCutoffOpticalDepth();
 
     // check for negative extinction, which requires explicit absorption
     for (auto medium : ms->media())
@@ -243,6 +252,9 @@ void Configuration::setupSelfBefore()
         _hasPanRadiationField = !_oligochromatic;
         _radiationFieldWLG = _oligochromatic ? dynamic_cast<OligoWavelengthGrid*>(_defaultWavelengthGrid)
                                              : ms->radiationFieldOptions()->radiationFieldWLG();
+        _hasPerThreadRadiationField = ms->radiationFieldOptions()->accumulationStrategy()
+                                      == RadiationFieldOptions::AccumulationStrategy::PerThread;
+        _maxRadiationFieldBufferMemory = ms->radiationFieldOptions()->maxAccumulationMemory() * 1e9;
     }
     _hasSecondaryRadiationField = _hasSecondaryIterations || _storeEmissionRadiationField;
 
@@ -269,11 +281,16 @@ void Configuration::setupSelfBefore()
         _dustEmissionSourceWeight = ms->dustEmissionOptions()->sourceWeight();
         _dustEmissionWavelengthBias = ms->dustEmissionOptions()->wavelengthBias();
         _dustEmissionWavelengthBiasDistribution = ms->dustEmissionOptions()->wavelengthBiasDistribution();
+        _precomputeDustEmissionSpectra = ms->dustEmissionOptions()->precomputeSpectra();
+        _maxDustEmissionSpectraMemory = ms->dustEmissionOptions()->maxSpectraMemory() * 1e9;
+        _reuseDustEmissionSpectra = _precomputeDustEmissionSpectra && ms->dustEmissionOptions()->reuseSpectra();
+        _dustEmissionSpectraReuseTolerance = ms->dustEmissionOptions()->reuseTolerance();
     }
 
     // retrieve media sampling options
     _numDensitySamples = ms->samplingOptions()->numDensitySamples();
     _numPropertySamples = ms->samplingOptions()->numPropertySamples();
+    _hasSpatialGridCache = ms->samplingOptions()->cacheSpatialGrid();
 
     // retrieve symmetry dimensions
     _modelDimension = max(ss->dimension(), ms->dimension());
@@ -324,6 +341,7 @@ void Configuration::setupSelfBefore()
     bool _hasConstantSectionMedium = _hasConstantPerceivedWavelength && !_hasVariableMedia && !hasExtraSpecificState;
     _hasSingleConstantSectionMedium = numMedia == 1 && _hasConstantSectionMedium;
     _hasMultipleConstantSectionMedia = numMedia > 1 && _hasConstantSectionMedium;
+    _hasShiftedConstantSectionMedia = !_hasConstantPerceivedWavelength && !_hasVariableMedia && !hasExtraSpecificState;
 
     // check for scattering dispersion
     for (auto medium : ms->media())
@@ -458,6 +476,14 @@ void Configuration::setupSelfAfter()
         _explicitAbsorption = true;
     }
 
+    // disable the peel-off optical depth cutoff when we have negative extinction because
+    // the optical depth along the path may decrease again after reaching the cutoff value
+    if (_hasNegativeExtinction && _peelOffCutoffOpticalDepth > 0.)
+    {
+        log->warning("  Disabling the peel-off optical depth cutoff to allow handling negative extinction");
+        _peelOffCutoffOpticalDepth = 0.;
+    }
+
     // enable forced scattering when we have a radiation field because
     // the photon cycle without forced scattering does not support storing the radiation field
     if (_hasRadiationField && !_forceScattering)
@@ -466,12 +492,37 @@ void Configuration::setupSelfAfter()
         _forceScattering = true;
     }
 
+    // disable photon packet splitting if it is not supported or if the splitting region is empty
+    if (_splitFactor > 1 && !_forceScattering)
+    {
+        log->warning("  Disabling photon packet splitting because it requires forced scattering");
+        _splitFactor = 1;
+    }
+    if (_splitFactor > 1
+        && (_splitRegion.xmax() <= _splitRegion.xmin() || _splitRegion.ymax() <= _splitRegion.ymin()
+            || _splitRegion.zmax() <= _splitRegion.zmin()))
+    {
+        log->warning("  Disabling photon packet splitting because the splitting region is empty");
+        _splitFactor = 1;
+    }
+
     // log photon cycle variations
     if (_hasMedium)
     {
         string ea = _explicitAbsorption ? "with" : "no";
         string fs = _forceScattering ? "with" : "no";
         log->info("  Photon life cycle: " + ea + " explicit absorption; " + fs + " forced scattering");
+        if (_forceScattering && _rouletteWeightThreshold > 0.)
+            log->info("  Russian roulette below weight fraction " + StringUtils::toString(_rouletteWeightThreshold)
+                      + " with survival probability " + StringUtils::toString(_rouletteSurvivalProbability));
+        if (_splitFactor > 1)
+            log->info("  Photon packets are split by a factor of " + std::to_string(_splitFactor) + " up to "
+                      + std::to_string(_maxSplitLevels) + " times");
+        if (_forceScattering && _streamForcedScatteringPaths)
+            log->info("  Forced-scattering paths are walked twice rather than stored");
+        if (_peelOffCutoffOpticalDepth > 0.)
+            log->info("  Peel-off Russian roulette beyond optical depth "
+                      + StringUtils::toString(_peelOffCutoffOpticalDepth));
     }
 
     // disable path length stretching if the wavelength of a photon packet can change during its lifetime
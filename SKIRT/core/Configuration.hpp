@@ -7,6 +7,7 @@
 #define CONFIGURATION_HPP
 
 #include "Array.hpp"
+#include "Box.hpp"
 #include "Range.hpp"
 #include "SimulationItem.hpp"
 class DisjointWavelengthGrid;
@@ -209,6 +210,15 @@ public:
         weight factors. */
     bool hasMultipleConstantSectionMedia() const { return _hasMultipleConstantSectionMedia; }
 
+    /** Returns true if the cross sections for all media depend only on the perceived wavelength,
+        while the perceived wavelength changes between cells because of Hubble expansion or moving
+        media, or false otherwise. In other words, this function returns true if neither
+        hasSingleConstantSectionMedium() nor hasMultipleConstantSectionMedia() returns true for the
+        sole reason that the perceived wavelength changes between cells. In this case, opacities
+        can be calculated by multiplying the cross section at the perceived wavelength for each
+        cell by the corresponding number density in the cell. */
+    bool hasShiftedConstantSectionMedia() const { return _hasShiftedConstantSectionMedia; }
+
     /** Returns true if a scattering interaction for one or more media may adjust the wavelength of
         the interacting photon packet, and false otherwise. */
     bool hasScatteringDispersion() const { return _hasScatteringDispersion; }
@@ -232,6 +242,10 @@ public:
     /** Returns the number of random spatial samples for determining other properties. */
     int numPropertySamples() const { return _numPropertySamples; }
 
+    /** Returns true if the structure of the spatial grid should be stored in and/or loaded from a
+        cache file for reuse across simulations, and false otherwise. */
+    bool hasSpatialGridCache() const { return _hasSpatialGridCache; }
+
     // ----> phases, iterations, number of packets
 
     /** Returns true if secondary emission must be calculated for any media type, and false
@@ -339,6 +353,34 @@ public:
         distribution. */
     double pathLengthBias() const { return _pathLengthBias; }
 
+    /** Returns the fraction of the launch weight below which forced-scattering photon packets are
+        subjected to Russian roulette, or zero if Russian roulette is disabled. */
+    double rouletteWeightThreshold() const { return _rouletteWeightThreshold; }
+
+    /** Returns the probability for a photon packet to survive Russian roulette. */
+    double rouletteSurvivalProbability() const { return _rouletteSurvivalProbability; }
+
+    /** Returns the number of photon packets resulting from splitting a forced-scattering photon
+        packet that enters the splitting region, or one if splitting is disabled. */
+    int splitFactor() const { return _splitFactor; }
+
+    /** Returns the maximum number of times that a photon packet and the photon packets resulting
+        from splitting it can be split along a single history. */
+    int maxSplitLevels() const { return _maxSplitLevels; }
+
+    /** Returns the splitting region, i.e. the box in which forced-scattering photon packets are
+        split if splitFactor() is larger than one. */
+    const Box& splitRegion() const { return _splitRegion; }
+
+    /** Returns true if the forced-scattering photon life cycle should walk each path twice (once
+        to calculate the total optical depth and store the radiation field, and once to locate the
+        interaction point) rather than storing the complete path, or false otherwise. */
+    bool streamForcedScatteringPaths() const { return _streamForcedScatteringPaths; }
+
+    /** Returns the extinction optical depth beyond which peel-off photon packets are subjected to
+        Russian roulette, or zero if there is no such cutoff. */
+    double peelOffCutoffOpticalDepth() const { return _peelOffCutoffOpticalDepth; }
+
     /** This enumeration lists the supported Lyman-alpha acceleration schemes. */
     enum class LyaAccelerationScheme { None, Constant, Variable };
 
@@ -376,6 +418,15 @@ public:
         if hasRadiationField() returns false. */
     DisjointWavelengthGrid* radiationFieldWLG() const { return _radiationFieldWLG; }
 
+    /** Returns true if the user requested to accumulate the radiation field in per-thread buffers,
+        and false if it should be accumulated directly in the shared table using atomic operations.
+        */
+    bool hasPerThreadRadiationField() const { return _hasPerThreadRadiationField; }
+
+    /** Returns the maximum number of bytes that may be allocated for per-thread radiation field
+        buffers before falling back to atomic accumulation. */
+    double maxRadiationFieldBufferMemory() const { return _maxRadiationFieldBufferMemory; }
+
     // ----> secondary emission
 
     /** Returns true if the radiation field must be stored during emission (for probing), and false
@@ -422,6 +473,22 @@ public:
         return _dustEmissionWavelengthBiasDistribution;
     }
 
+    /** Returns true if the dust emission spectra for all spatial cells should be calculated before
+        launching secondary photon packets, and false if they should be calculated on the fly. */
+    bool precomputeDustEmissionSpectra() const { return _precomputeDustEmissionSpectra; }
+
+    /** Returns the maximum number of bytes that may be allocated for the precomputed dust emission
+        spectra before falling back to calculating the spectra on the fly. */
+    double maxDustEmissionSpectraMemory() const { return _maxDustEmissionSpectraMemory; }
+
+    /** Returns true if precomputed dust emission spectra may be reused from one secondary emission
+        iteration to the next when the radiation field has barely changed, and false otherwise. */
+    bool reuseDustEmissionSpectra() const { return _reuseDustEmissionSpectra; }
+
+    /** Returns the relative change in the radiation field below which a precomputed dust emission
+        spectrum is reused from the previous secondary emission iteration. */
+    double dustEmissionSpectraReuseTolerance() const { return _dustEmissionSpectraReuseTolerance; }
+
     // ----> gas emission
 
     /** Returns true if gas emission must be calculated, and false otherwise. */
@@ -461,6 +528,7 @@ private:
     bool _hasConstantPerceivedWavelength{false};
     bool _hasSingleConstantSectionMedium{false};
     bool _hasMultipleConstantSectionMedia{false};
+    bool _hasShiftedConstantSectionMedia{false};
     bool _hasScatteringDispersion{false};
     bool _hasPolarization{false};
     bool _hasSpheroidalPolarization{false};
@@ -468,6 +536,7 @@ private:
     // media sampling
     int _numDensitySamples{100};
     int _numPropertySamples{1};
+    bool _hasSpatialGridCache{false};
 
     // phases, iterations, number of packets
     bool _hasSecondaryEmission{false};
@@ -499,6 +568,13 @@ private:
     double _minWeightReduction{1e4};
     int _minScattEvents{0};
     double _pathLengthBias{0.5};
+    double _rouletteWeightThreshold{0.};
+    double _rouletteSurvivalProbability{0.1};
+    int _splitFactor{1};
+    int _maxSplitLevels{1};
+    Box _splitRegion;
+    bool _streamForcedScatteringPaths{false};
+    double _peelOffCutoffOpticalDepth{0.};
     bool _hasLymanAlpha{false};
     LyaAccelerationScheme _lyaAccelerationScheme{LyaAccelerationScheme::Variable};
     double _lyaAccelerationStrength{1.};
@@ -509,6 +585,8 @@ private:
     bool _hasPanRadiationField{false};
     bool _hasSecondaryRadiationField{false};
     DisjointWavelengthGrid* _radiationFieldWLG{nullptr};
+    bool _hasPerThreadRadiationField{false};
+    double _maxRadiationFieldBufferMemory{4e9};
 
     // secondary emission
     bool _storeEmissionRadiationField{false};
@@ -524,6 +602,10 @@ private:
     double _dustEmissionSourceWeight{1.};
     double _dustEmissionWavelengthBias{0.5};
     WavelengthDistribution* _dustEmissionWavelengthBiasDistribution{nullptr};
+    bool _precomputeDustEmissionSpectra{false};
+    double _maxDustEmissionSpectraMemory{4e9};
+    bool _reuseDustEmissionSpectra{false};
+    double _dustEmissionSpectraReuseTolerance{0.01};
 
     // gas emission
     bool _hasGasEmission{false};
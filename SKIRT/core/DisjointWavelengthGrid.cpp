@@ -78,6 +78,9 @@ void DisjointWavelengthGrid::setWavelengthRange(const Array& lambdav, bool logSc
     _ellv[0] = -1;
     for (size_t ell = 0; ell != n; ++ell) _ellv[ell + 1] = ell;
     _ellv[n + 1] = -1;
+
+    // prepare for fast bin lookup
+    setupBinLookup();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -133,6 +136,9 @@ void DisjointWavelengthGrid::setWavelengthBins(const Array& lambdav, double rela
         _ellv[2 * ell + 1] = ell;
         _ellv[2 * ell + 2] = -1;  // regions between the bins are considered out of range
     }
+
+    // prepare for fast bin lookup
+    setupBinLookup();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -188,6 +194,9 @@ void DisjointWavelengthGrid::setWavelengthBorders(const Array& borderv, bool log
     _ellv[0] = -1;
     for (size_t ell = 0; ell != n; ++ell) _ellv[ell + 1] = ell;
     _ellv[n + 1] = -1;
+
+    // prepare for fast bin lookup
+    setupBinLookup();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -271,6 +280,9 @@ void DisjointWavelengthGrid::setWavelengthSegments(const vector<double>& borderv
             _ellv[k + 1] = -1;
         }
     }
+
+    // prepare for fast bin lookup
+    setupBinLookup();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -317,15 +329,11 @@ double DisjointWavelengthGrid::transmission(int /*ell*/, double /*lambda*/) cons
 
 ////////////////////////////////////////////////////////////////////
 
-vector<int> DisjointWavelengthGrid::bins(double lambda) const
+void DisjointWavelengthGrid::bins(double lambda, BinList& ellv) const
 {
-    // get the bin index, or -1 for "out of range"
+    ellv.clear();
     int ell = bin(lambda);
-
-    // wrap the result in a list
-    vector<int> result;
-    if (ell >= 0) result.push_back(ell);
-    return result;
+    if (ell >= 0) ellv.add(ell);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -335,7 +343,28 @@ int DisjointWavelengthGrid::bin(double lambda) const
     // get the index of the phantom wavelength bin defined by the list of all K borders (where K=N+1 or K=N*2)
     //  0  => out of range on the left side
     //  K  => out of range on the right side
-    size_t index = std::upper_bound(begin(_borderv), end(_borderv), lambda) - begin(_borderv);
+    size_t index;
+    if (_lookup == Lookup::Search)
+    {
+        index = std::upper_bound(begin(_borderv), end(_borderv), lambda) - begin(_borderv);
+    }
+    else
+    {
+        size_t numBorders = _borderv.size();
+        if (!(lambda >= _borderv[0]))
+            index = 0;
+        else if (lambda >= _borderv[numBorders - 1])
+            index = numBorders;
+        else
+        {
+            // estimate the index from the uniform border spacing, and correct for any round-off errors
+            double x = _lookup == Lookup::Linear ? lambda : log(lambda);
+            index = static_cast<size_t>(max(0., (x - _lookupOffset) * _lookupFactor)) + 1;
+            if (index > numBorders - 1) index = numBorders - 1;
+            while (lambda < _borderv[index - 1]) --index;
+            while (lambda >= _borderv[index]) ++index;
+        }
+    }
 
     // map this index to the actual wavelength bin index, or to -1 for "out of range"
     return _ellv[index];
@@ -343,6 +372,33 @@ int DisjointWavelengthGrid::bin(double lambda) const
 
 ////////////////////////////////////////////////////////////////////
 
+void DisjointWavelengthGrid::setupBinLookup()
+{
+    // returns true if the specified transformed border values are uniformly spaced within a small tolerance,
+    // and if so, stores the offset and inverse spacing
+    auto isUniform = [this](const Array& xv) {
+        size_t numIntervals = xv.size() - 1;
+        if (numIntervals < 2) return false;
+        double dx = (xv[numIntervals] - xv[0]) / numIntervals;
+        for (size_t k = 1; k != numIntervals; ++k)
+            if (abs(xv[k] - (xv[0] + k * dx)) > 1e-3 * dx) return false;
+        _lookupOffset = xv[0];
+        _lookupFactor = 1. / dx;
+        return true;
+    };
+
+    // use arithmetic lookup for grids with borders that are uniformly spaced in linear or logarithmic space,
+    // and a binary search for all other grids
+    if (isUniform(_borderv))
+        _lookup = Lookup::Linear;
+    else if (isUniform(log(_borderv)))
+        _lookup = Lookup::Logarithmic;
+    else
+        _lookup = Lookup::Search;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Array DisjointWavelengthGrid::extlambdav() const
 {
     int n = _lambdav.size();
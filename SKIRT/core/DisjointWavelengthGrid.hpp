@@ -158,16 +158,21 @@ public:
         1. */
     double transmission(int ell, double lambda) const override;
 
-    /** This function returns a single-element list with the index \f$\ell\f$ of the wavelength bin
+    /** This function stores in the specified list the index \f$\ell\f$ of the wavelength bin
         that contains the specified wavelength \f$\lambda\f$, i.e. for which
         \f$\lambda^\mathrm{left}_\ell <= \lambda < \lambda^\mathrm{right}_\ell\f$. If \f$\lambda\f$
-        does not lie inside one of the wavelength bins, the function returns an empty list. */
-    vector<int> bins(double lambda) const override;
+        does not lie inside one of the wavelength bins, the list is left empty. */
+    void bins(double lambda, BinList& ellv) const override;
 
     /** This function returns the index \f$\ell\f$ of the wavelength bin that contains the
         specified wavelength \f$\lambda\f$, i.e. for which \f$\lambda^\mathrm{left}_\ell <= \lambda
         < \lambda^\mathrm{right}_\ell\f$. If \f$\lambda\f$ does not lie inside one of the
-        wavelength bins, the function returns -1. */
+        wavelength bins, the function returns -1.
+
+        If the bin borders are uniformly spaced in linear or logarithmic space, as is the case for
+        example for the LinWavelengthGrid and LogWavelengthGrid classes, the function estimates the
+        index arithmetically in constant time and then corrects it for any round-off errors by
+        comparing with the actual borders. For other grids, it performs a binary search. */
     int bin(double lambda) const override;
 
     //=============== Functions specific to disjoint wavelength grids =================
@@ -197,6 +202,15 @@ public:
         extlambdav() function over the wavelength range. */
     Array extdlambdav() const;
 
+    //======================== Private helpers ========================
+
+private:
+    /** This function determines whether the bin borders are uniformly spaced in linear or
+        logarithmic space, and if so, prepares the data members used by the bin() function for
+        calculating bin indices arithmetically. It is called at the end of each of the
+        setWavelengthXXX() functions. */
+    void setupBinLookup();
+
     //======================== Data Members ========================
 
 private:
@@ -207,6 +221,12 @@ private:
     Array _lambdarightv;  // N right wavelength bin widths
     Array _borderv;       // K=N+1 or K=N*2 ordered border points (depending on whether bins are adjacent)
     vector<int> _ellv;    // K+1 indices of the wavelength bins defined by the border points, or -1 if out of range
+
+    // initialized by setupBinLookup() to accelerate the bin() function
+    enum class Lookup { Search, Linear, Logarithmic };
+    Lookup _lookup{Lookup::Search};  // the lookup method
+    double _lookupOffset{0.};        // the first border point (in linear or logarithmic space)
+    double _lookupFactor{0.};        // the inverse of the border spacing (in linear or logarithmic space)
 };
 
 //////////////////////////////////////////////////////////////////////
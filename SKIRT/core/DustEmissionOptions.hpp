@@ -16,7 +16,29 @@
 
 /** The DustEmissionOptions class simply offers a number of configuration options related to
     thermal emission from dust. In a mode where dust emission is enabled, the simulation also
-    needs a wavelength grid on which to calculate the dust emission spectrum. */
+    needs a wavelength grid on which to calculate the dust emission spectrum.
+
+    By default, the normalized emission spectrum for a spatial cell is calculated when the first
+    photon packet is launched from that cell, and it is remembered only while subsequent packets
+    are launched from the same cell by the same execution thread. The \em precomputeSpectra option
+    requests that the emission spectra for all spatial cells (or library entries) are calculated
+    in parallel before launching any secondary photon packets and stored in single precision, so
+    that the launch procedure reduces to sampling from these spectra. If the memory required for
+    storing the spectra exceeds the budget specified by the \em maxSpectraMemory option, the
+    simulation issues a warning and proceeds by calculating the spectra on the fly.
+
+    When the spectra are precomputed, the \em reuseSpectra option further requests that each
+    spectrum is stored together with the radiation field from which it was calculated. During
+    subsequent secondary emission iterations, a spectrum is then copied from the previous iteration
+    rather than recalculated if the relative change in this radiation field, i.e. the integrated
+    absolute difference divided by the integrated previous field, is below the tolerance specified
+    by the \em reuseTolerance option, and if the medium state in the cell, including the dust
+    densities, has not been changed by a dynamic medium state update since the spectrum was
+    calculated. This can substantially reduce the calculation time in later iterations, when the
+    radiation field in most cells has converged. Because the spectra of the previous iteration
+    remain in memory while the new spectra are being calculated, the memory budget must
+    accommodate both sets. If only the new spectra fit, the simulation issues a warning and
+    recalculates all spectra for that iteration. */
 class DustEmissionOptions : public SimulationItem, public SourceWavelengthRangeInterface
 {
     /** The enumeration type indicating the method used for dust emission calculations. */
@@ -79,6 +101,30 @@ class DustEmissionOptions : public SimulationItem, public SourceWavelengthRangeI
         ATTRIBUTE_RELEVANT_IF(wavelengthBiasDistribution, "wavelengthBias")
         ATTRIBUTE_DISPLAYED_IF(wavelengthBiasDistribution, "Level3")
 
+        PROPERTY_BOOL(precomputeSpectra, "precompute the emission spectra for all cells before launching packets")
+        ATTRIBUTE_DEFAULT_VALUE(precomputeSpectra, "false")
+        ATTRIBUTE_DISPLAYED_IF(precomputeSpectra, "Level3")
+
+        PROPERTY_DOUBLE(maxSpectraMemory, "the maximum memory for the precomputed emission spectra (in GB)")
+        ATTRIBUTE_MIN_VALUE(maxSpectraMemory, "[0")
+        ATTRIBUTE_MAX_VALUE(maxSpectraMemory, "1e6]")
+        ATTRIBUTE_DEFAULT_VALUE(maxSpectraMemory, "4")
+        ATTRIBUTE_RELEVANT_IF(maxSpectraMemory, "precomputeSpectra")
+        ATTRIBUTE_DISPLAYED_IF(maxSpectraMemory, "Level3")
+
+        PROPERTY_BOOL(reuseSpectra, "reuse emission spectra from the previous iteration if the radiation field barely "
+                                    "changed")
+        ATTRIBUTE_DEFAULT_VALUE(reuseSpectra, "false")
+        ATTRIBUTE_RELEVANT_IF(reuseSpectra, "precomputeSpectra")
+        ATTRIBUTE_DISPLAYED_IF(reuseSpectra, "Level3")
+
+        PROPERTY_DOUBLE(reuseTolerance, "the relative radiation field change below which emission spectra are reused")
+        ATTRIBUTE_MIN_VALUE(reuseTolerance, "[0")
+        ATTRIBUTE_MAX_VALUE(reuseTolerance, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(reuseTolerance, "0.01")
+        ATTRIBUTE_RELEVANT_IF(reuseTolerance, "precomputeSpectra&reuseSpectra")
+        ATTRIBUTE_DISPLAYED_IF(reuseTolerance, "Level3")
+
     ITEM_END()
 
     //======================== Other Functions =======================
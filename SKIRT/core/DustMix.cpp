@@ -337,6 +337,27 @@ double DustMix::sectionExt(double lambda) const
 
 ////////////////////////////////////////////////////////////////////
 
+double DustMix::sectionAbsWithHint(double lambda, int& ell) const
+{
+    return _sigmaabsv[indexForLambda(lambda, ell)];
+}
+
+////////////////////////////////////////////////////////////////////
+
+double DustMix::sectionScaWithHint(double lambda, int& ell) const
+{
+    return _sigmascav[indexForLambda(lambda, ell)];
+}
+
+////////////////////////////////////////////////////////////////////
+
+double DustMix::sectionExtWithHint(double lambda, int& ell) const
+{
+    return _sigmaextv[indexForLambda(lambda, ell)];
+}
+
+////////////////////////////////////////////////////////////////////
+
 double DustMix::asymmpar(double lambda) const
 {
     return _asymmparv[indexForLambda(lambda)];
@@ -184,6 +184,17 @@ private:
         are stored in data members during setup. */
     int indexForLambda(double lambda) const;
 
+    /** This function returns the index in the private wavelength grid corresponding to the
+        specified wavelength, just like the other version of this function. If the specified
+        wavelength falls in the bin with the index given by \em ell, that index is returned
+        without performing a search. Otherwise, the index is determined through a binary search
+        and stored in \em ell. */
+    int indexForLambda(double lambda, int& ell) const
+    {
+        if (ell < 0 || lambda < _lambdav[ell] || lambda >= _lambdav[ell + 1]) ell = indexForLambda(lambda);
+        return ell;
+    }
+
     /** This function returns the index in the private scattering angle grid corresponding to the
         specified scattering angle. The parameters for converting a scattering angle to the
         appropriate index are built-in constants. */
@@ -234,6 +245,19 @@ public:
         value from a table that was pre-computed during setup. */
     double sectionExt(double lambda) const override;
 
+    /** This function returns the absorption cross section per entity at wavelength \f$\lambda\f$,
+        reusing the cached wavelength index \em ell if the wavelength falls in the same bin as
+        before, and updating it otherwise. */
+    double sectionAbsWithHint(double lambda, int& ell) const override;
+
+    /** This function returns the scattering cross section per entity at wavelength
+        \f$\lambda\f$, reusing or updating the cached wavelength index \em ell. */
+    double sectionScaWithHint(double lambda, int& ell) const override;
+
+    /** This function returns the extinction cross section per entity at wavelength
+        \f$\lambda\f$, reusing or updating the cached wavelength index \em ell. */
+    double sectionExtWithHint(double lambda, int& ell) const override;
+
     /** This function returns the scattering asymmetry parameter \f$g_\lambda =
         \left<\cos\theta\right>\f$ at wavelength \f$\lambda\f$, which is used with the
         HenyeyGreenstein scattering mode. It retrieves the requested value from a table that was
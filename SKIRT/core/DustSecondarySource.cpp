@@ -16,6 +16,7 @@
 #include "PolarizationProfileInterface.hpp"
 #include "ProcessManager.hpp"
 #include "Random.hpp"
+#include "SpecialFunctions.hpp"
 #include "StringUtils.hpp"
 #include "Units.hpp"
 #include "VelocityInterface.hpp"
@@ -48,7 +49,7 @@ double DustSecondarySource::prepareLuminosities()
     // --------- library mapping ---------
 
     // obtain the spatial cell library mapping (from cell indices to library entry indices);
-    // pass the cell luminosities to the library so it can avoid mapping zero-luminosity cells
+    // pass the cell luminosities to the library so it can avoid mapping zero-luminosity cells and weight the others
     _nv = _config->cellLibrary()->mapping(_Lv);
 
     // construct a list of spatial cell indices sorted so that cells belonging to the same entry are consecutive
@@ -109,6 +110,11 @@ double DustSecondarySource::prepareLuminosities()
                   + StringUtils::toString(static_cast<double>(totMappedCells) / usedEntries, 'f', 1));
     }
 
+    // --------- emission spectra ---------
+
+    // precalculate the emission spectra for all emitting cells, if requested
+    if (_config->precomputeDustEmissionSpectra()) precomputeSpectra();
+
     // return the total luminosity
     return L;
 }
@@ -317,6 +323,10 @@ namespace
         }
 
     public:
+        // returns the normalized regular and cumulative emission spectra, discretized on the dust emission grid
+        const Array& pv() const { return _pv; }
+        const Array& Pv() const { return _Pv; }
+
         // returns a random wavelength generated from the spectral distribution
         double generateWavelength(Random* random) const { return random->cdfLogLog(_lambdav, _pv, _Pv); }
 
@@ -503,45 +513,90 @@ namespace
         }
     };
 
-    // setup instances of the above classes to cache dust emission information for each parallel execution thread
-    thread_local DustCellEmission t_dustcell;
-    thread_local DustCellPolarisedEmission t_dustcellpol;
-}
+    // An instance of this class offers the same interface for generating and evaluating wavelengths as the
+    // DustCellEmission class, using a normalized emission spectrum precomputed and stored in single precision.
+    class PrecomputedSpectrum
+    {
+    private:
+        const Array& _lambdav;  // the wavelength grid
+        const float* _pv;       // the normalized emission spectrum
+        const float* _Pv;       // the normalized cumulative emission spectrum
+        int _n;                 // the number of wavelengths
 
-////////////////////////////////////////////////////////////////////
+    public:
+        PrecomputedSpectrum(const Array& lambdav, const float* pv, const float* Pv)
+            : _lambdav(lambdav), _pv(pv), _Pv(Pv), _n(lambdav.size())
+        {}
 
-void DustSecondarySource::launch(PhotonPacket* pp, size_t historyIndex, double L) const
-{
-    // select the spatial cell from which to launch based on the history index of this photon packet
-    auto p = std::upper_bound(_Iv.cbegin(), _Iv.cend(), historyIndex) - _Iv.cbegin() - 1;
-    auto m = _mv[p];
+        // returns a random wavelength generated from the spectral distribution, mimicking Random::cdfLogLog()
+        double generateWavelength(Random* random) const
+        {
+            double X = random->uniform();
+            int i = max(0, static_cast<int>(std::upper_bound(_Pv, _Pv + _n - 1, X) - _Pv) - 1);
+            double alpha = log(static_cast<double>(_pv[i + 1]) / _pv[i]) / log(_lambdav[i + 1] / _lambdav[i]);
+            double x = (X - _Pv[i]) / (_pv[i] * _lambdav[i]);
+
+            // near P=1, a single step of the single-precision cumulative distribution can exceed the actual
+            // probability of a tail bin by orders of magnitude, so that X - Pv[i] overshoots the bin's mass;
+            // in a steep tail this makes the argument of the power in gexp() nonpositive, producing NaN or
+            // infinity; we therefore clamp the result to the bin borders (including the NaN case)
+            if (1. + (1. + alpha) * x <= 0.) return _lambdav[i + 1];
+            double lambda = _lambdav[i] * SpecialFunctions::gexp(-alpha, x);
+            if (!(lambda >= _lambdav[i])) return _lambdav[i];
+            if (!(lambda <= _lambdav[i + 1])) return _lambdav[i + 1];
+            return lambda;
+        }
 
-    // calculate the weight related to biased source selection
-    double ws = _Lv[m] / _Wv[m];
+        // returns the normalized specific luminosity for the given wavelength
+        double specificLuminosity(double lambda) const
+        {
+            int i = NR::locateFail(_lambdav, lambda);
+            if (i < 0) return 0.;
+            return NR::interpolateLogLog(lambda, _lambdav[i], _lambdav[i + 1], _pv[i], _pv[i + 1]);
+        }
+    };
 
-    // calculate the emission spectrum and bulk velocity for this cell, if not already available
-    t_dustcell.calculateIfNeeded(p, _mv, _nv, _ms, _config);
+    // An instance of this class provides the bulk velocity of the cell from which a photon packet is launched
+    // when the emission spectra have been precomputed
+    class DustCellVelocity : public VelocityInterface
+    {
+    private:
+        Vec _bfv;
 
-    // generate a random wavelength from the emission spectrum for the cell and/or from the bias distribution
-    double lambda, w;
+    public:
+        DustCellVelocity() {}
+        void setBulkVelocity(Vec bfv) { _bfv = bfv; }
+        Vec velocity() const override { return _bfv; }
+    };
+
+    // setup instances of the above classes to cache dust emission information for each parallel execution thread
+    thread_local DustCellEmission t_dustcell;
+    thread_local DustCellPolarisedEmission t_dustcellpol;
+    thread_local DustCellVelocity t_velocity;
+
+    // generates a random wavelength from the specified emission spectrum and/or from the configured bias
+    // distribution, and calculates the corresponding bias weight factor
+    template<class Spectrum>
+    void generateBiasedWavelength(const Spectrum& spectrum, Configuration* config, Random* random, double& lambda,
+                                  double& w)
     {
-        double xi = _config->dustEmissionWavelengthBias();
+        double xi = config->dustEmissionWavelengthBias();
         if (!xi)
         {
             // no biasing -- simply use the intrinsic spectral distribution
-            lambda = t_dustcell.generateWavelength(_random);
+            lambda = spectrum.generateWavelength(random);
             w = 1.;
         }
         else
         {
             // biasing -- use one or the other distribution
-            if (_random->uniform() > xi)
-                lambda = t_dustcell.generateWavelength(_random);
+            if (random->uniform() > xi)
+                lambda = spectrum.generateWavelength(random);
             else
-                lambda = _config->dustEmissionWavelengthBiasDistribution()->generateWavelength();
+                lambda = config->dustEmissionWavelengthBiasDistribution()->generateWavelength();
 
             // calculate the compensating weight factor
-            double s = t_dustcell.specificLuminosity(lambda);
+            double s = spectrum.specificLuminosity(lambda);
             if (!s)
             {
                 // if the wavelength can't occur in the intrinsic distribution,
@@ -552,17 +607,309 @@ void DustSecondarySource::launch(PhotonPacket* pp, size_t historyIndex, double L
             else
             {
                 // regular composite bias weight
-                double b = _config->dustEmissionWavelengthBiasDistribution()->probability(lambda);
+                double b = config->dustEmissionWavelengthBiasDistribution()->probability(lambda);
                 w = s / ((1 - xi) * s + xi * b);
             }
         }
     }
 
+    // returns the radiation field used by the DustCellEmission class to calculate the emission spectrum
+    // for the library entry of the cell with the given launch-order index p, i.e. the average radiation field
+    // of the cells mapped to the same library entry, starting at p
+    Array entryMeanIntensity(int p, const vector<int>& mv, const vector<int>& nv, const MediumSystem* ms)
+    {
+        int numCells = mv.size();
+        int n = nv[mv[p]];
+        Array Jv = ms->meanIntensity(mv[p]);
+        int pp = p + 1;
+        for (; pp != numCells; ++pp)
+        {
+            if (nv[mv[pp]] != n) break;
+            Jv += ms->meanIntensity(mv[pp]);
+        }
+        if (pp - p > 1) Jv /= pp - p;
+        return Jv;
+    }
+
+    // returns the relative change of the radiation field Jv compared to the previous radiation field J0v,
+    // defined as the integrated absolute difference divided by the integrated previous field
+    double relativeChange(const Array& Jv, const float* J0v, const Array& dlambdav)
+    {
+        double sumDiff = 0.;
+        double sumPrev = 0.;
+        int numWavelengths = Jv.size();
+        for (int ell = 0; ell != numWavelengths; ++ell)
+        {
+            sumDiff += abs(Jv[ell] - J0v[ell]) * dlambdav[ell];
+            sumPrev += J0v[ell] * dlambdav[ell];
+        }
+        return sumPrev > 0. ? sumDiff / sumPrev : (sumDiff > 0. ? 1. : 0.);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustSecondarySource::precomputeSpectra()
+{
+    auto log = find<Log>();
+    int numCells = _ms->numCells();
+
+    // if requested, keep the spectra calculated during the previous iteration so that they can be reused
+    bool reuse = _config->reuseDustEmissionSpectra();
+    vector<int> sv0;
+    vector<float> pvv0, Pvv0, Jvv0;
+    vector<int> rv0;
+    if (reuse && _hasPrecomputedSpectra)
+    {
+        sv0.swap(_sv);
+        pvv0.swap(_pvv);
+        Pvv0.swap(_Pvv);
+        Jvv0.swap(_Jvv);
+        rv0.swap(_revisionv);
+    }
+    _hasPrecomputedSpectra = false;
+
+    // determine the launch-order index of the first emitting cell for each library entry, and assign a spectrum
+    // index to each emitting cell; if there is a single dust medium, the spectrum does not depend on the density
+    // so that all cells mapped to a library entry share the same spectrum; otherwise each cell has its own spectrum
+    bool perEntry = _ms->dustMediumIndices().size() == 1;
+    // the spectra for each library entry have consecutive indices
+    vector<int> firstv;          // indexed on emitting library entry, with extra entry at the end
+    vector<int> firstSpectrumv;  // indexed on emitting library entry, with extra entry at the end
+    _sv.assign(numCells, -1);
+    int numSpectra = 0;
+    for (int p = 0; p != numCells; ++p)
+    {
+        int m = _mv[p];
+        if (_Lv[m] > 0.)
+        {
+            bool newEntry = firstv.empty() || _nv[_mv[firstv.back()]] != _nv[m];
+            if (newEntry)
+            {
+                firstv.push_back(p);
+                firstSpectrumv.push_back(numSpectra);
+            }
+            if (newEntry || !perEntry) numSpectra++;
+            _sv[m] = numSpectra - 1;
+        }
+    }
+    int numEntries = firstv.size();
+    firstv.push_back(numCells);
+    firstSpectrumv.push_back(numSpectra);
+
+    // obtain the wavelength grid of the normalized spectra by normalizing a flat spectrum
+    auto wavelengthGrid = _config->dustEmissionWLG();
+    Array pv, Pv;
+    NR::cdf<NR::interpolateLogLog>(_lambdav, pv, Pv, wavelengthGrid->extlambdav(),
+                                   Array(1., wavelengthGrid->extlambdav().size()), wavelengthGrid->wavelengthRange());
+    _numLambda = _lambdav.size();
+    const Array& dlambdav = _config->radiationFieldWLG()->dlambdav();
+    _numFieldLambda = reuse ? dlambdav.size() : 0;
+
+    // verify that the spectra fit in the memory budget, including the spectra of the previous iteration,
+    // which remain allocated while the new spectra are being calculated; if only the latter fit, release
+    // the previous spectra and calculate all spectra from scratch
+    double bytes = (2. * _numLambda + _numFieldLambda) * numSpectra * sizeof(float)
+                   + (static_cast<double>(numCells) + (reuse ? numSpectra : 0)) * sizeof(int);
+    double retainedBytes = static_cast<double>(pvv0.size() + Pvv0.size() + Jvv0.size()) * sizeof(float)
+                           + static_cast<double>(sv0.size() + rv0.size()) * sizeof(int);
+    if (retainedBytes > 0. && bytes + retainedBytes > _config->maxDustEmissionSpectraMemory()
+        && bytes <= _config->maxDustEmissionSpectraMemory())
+    {
+        log->warning("Not reusing dust emission spectra because keeping them would require an additional "
+                     + StringUtils::toMemSizeString(retainedBytes) + " of memory");
+        vector<int>().swap(sv0);
+        vector<float>().swap(pvv0);
+        vector<float>().swap(Pvv0);
+        vector<float>().swap(Jvv0);
+        vector<int>().swap(rv0);
+        retainedBytes = 0.;
+    }
+    bytes += retainedBytes;
+    if (bytes > _config->maxDustEmissionSpectraMemory())
+    {
+        log->warning("Not precomputing dust emission spectra because they would require "
+                     + StringUtils::toMemSizeString(bytes) + " of memory");
+        _sv.clear();
+        _pvv.clear();
+        _Pvv.clear();
+        _Jvv.clear();
+        _revisionv.clear();
+        return;
+    }
+    log->info("Precomputing " + std::to_string(numSpectra) + " dust emission spectra using "
+              + StringUtils::toMemSizeString(bytes) + " of memory");
+    _pvv.resize(static_cast<size_t>(numSpectra) * _numLambda);
+    _Pvv.resize(static_cast<size_t>(numSpectra) * _numLambda);
+    _Jvv.resize(static_cast<size_t>(numSpectra) * _numFieldLambda);
+    _revisionv.resize(reuse ? numSpectra : 0);
+
+    // distribute the library entries over the threads in all processes; the spectra are communicated
+    // between processes afterwards because photon packets may be launched from any cell in any process
+    double tolerance = _config->dustEmissionSpectraReuseTolerance();
+    vector<char> reusedv(numSpectra);      // flag indicating whether each spectrum has been reused
+    vector<char> calculatedv(numEntries);  // flag indicating whether this process handled each library entry
+    log->infoSetElapsed(numEntries);
+    find<ParallelFactory>()->parallelDistributed()->call(numEntries, [&](size_t firstIndex, size_t numIndices) {
+        // process each library entry starting from its first emitting cell, so that the calculated spectra are
+        // identical to those calculated on the fly when a single thread launches all packets for the entry
+        DustCellEmission calculator;
+        string progress = "Precomputed dust emission spectra: ";
+        for (size_t e = firstIndex; e != firstIndex + numIndices; ++e)
+        {
+            calculatedv[e] = 1;
+
+            // if reuse is enabled, obtain the radiation field used for the spectra of this library entry
+            Array Jv;
+            if (reuse) Jv = entryMeanIntensity(firstv[e], _mv, _nv, _ms);
+
+            int previous = -1;
+            bool calculated = false;
+            for (int p = firstv[e]; p != firstv[e + 1]; ++p)
+            {
+                int m = _mv[p];
+                int s = _sv[m];
+                if (s < 0 || s == previous) continue;
+                previous = s;
+                float* pvs = &_pvv[static_cast<size_t>(s) * _numLambda];
+                float* Pvs = &_Pvv[static_cast<size_t>(s) * _numLambda];
+
+                if (reuse)
+                {
+                    // if the spectrum for this cell in the previous iteration was calculated from a sufficiently
+                    // similar radiation field, and the medium state of the cell (which determines, e.g., the relative
+                    // contributions of multiple dust media) has not been updated since, simply copy the spectrum,
+                    // including the radiation field and state revision from which it was calculated so that gradual
+                    // changes over multiple iterations cannot accumulate unnoticed
+                    float* Jvs = &_Jvv[static_cast<size_t>(s) * _numFieldLambda];
+                    int s0 = sv0.empty() ? -1 : sv0[m];
+                    if (s0 >= 0 && _ms->stateRevision(m) <= rv0[s0])
+                    {
+                        const float* Jvs0 = &Jvv0[static_cast<size_t>(s0) * _numFieldLambda];
+                        if (relativeChange(Jv, Jvs0, dlambdav) < tolerance)
+                        {
+                            std::copy_n(Jvs0, _numFieldLambda, Jvs);
+                            _revisionv[s] = rv0[s0];
+                            std::copy_n(&pvv0[static_cast<size_t>(s0) * _numLambda], _numLambda, pvs);
+                            std::copy_n(&Pvv0[static_cast<size_t>(s0) * _numLambda], _numLambda, Pvs);
+                            reusedv[s] = 1;
+                            continue;
+                        }
+                    }
+
+                    // otherwise remember the radiation field and state revision for the spectrum to be calculated
+                    for (int ell = 0; ell != _numFieldLambda; ++ell) Jvs[ell] = static_cast<float>(Jv[ell]);
+                    _revisionv[s] = _ms->stateRevision();
+
+                    // make sure that the calculator handles the library entry starting from its first emitting cell
+                    if (!calculated && p != firstv[e]) calculator.calculateIfNeeded(firstv[e], _mv, _nv, _ms, _config);
+                    calculated = true;
+                }
+
+                calculator.calculateIfNeeded(p, _mv, _nv, _ms, _config);
+                const Array& pv = calculator.pv();
+                const Array& Pv = calculator.Pv();
+                for (int ell = 0; ell != _numLambda; ++ell)
+                {
+                    pvs[ell] = static_cast<float>(pv[ell]);
+                    Pvs[ell] = static_cast<float>(Pv[ell]);
+                }
+            }
+            log->infoIfElapsed(progress, 1);
+        }
+    });
+
+    // communicate the spectra between processes, if needed
+    if (ProcessManager::isMultiProc())
+    {
+        size_t numFloats = 2 * _numLambda + _numFieldLambda + (reuse ? 1 : 0);
+        auto producer = [&](vector<double>& data) {
+            for (int e = 0; e != numEntries; ++e)
+            {
+                if (calculatedv[e])
+                {
+                    data.push_back(e);
+                    for (int s = firstSpectrumv[e]; s != firstSpectrumv[e + 1]; ++s)
+                    {
+                        data.push_back(reusedv[s]);
+                        size_t offset = static_cast<size_t>(s) * _numLambda;
+                        data.insert(data.end(), _pvv.begin() + offset, _pvv.begin() + offset + _numLambda);
+                        data.insert(data.end(), _Pvv.begin() + offset, _Pvv.begin() + offset + _numLambda);
+                        offset = static_cast<size_t>(s) * _numFieldLambda;
+                        data.insert(data.end(), _Jvv.begin() + offset, _Jvv.begin() + offset + _numFieldLambda);
+                        if (reuse) data.push_back(_revisionv[s]);
+                    }
+                }
+            }
+        };
+        auto consumer = [&](const vector<double>& data) {
+            for (auto in = data.begin(); in != data.end();)
+            {
+                int e = *in++;
+                for (int s = firstSpectrumv[e]; s != firstSpectrumv[e + 1]; ++s)
+                {
+                    reusedv[s] = *in++;
+                    size_t offset = static_cast<size_t>(s) * _numLambda;
+                    std::copy(in, in + _numLambda, _pvv.begin() + offset);
+                    std::copy(in + _numLambda, in + 2 * _numLambda, _Pvv.begin() + offset);
+                    offset = static_cast<size_t>(s) * _numFieldLambda;
+                    std::copy(in + 2 * _numLambda, in + 2 * _numLambda + _numFieldLambda, _Jvv.begin() + offset);
+                    if (reuse) _revisionv[s] = in[2 * _numLambda + _numFieldLambda];
+                    in += numFloats;
+                }
+            }
+        };
+        ProcessManager::broadcastAllToAll(producer, consumer);
+    }
+    _hasPrecomputedSpectra = true;
+
+    // report the fraction of reused spectra
+    if (!sv0.empty())
+    {
+        int numReused = std::count(reusedv.begin(), reusedv.end(), 1);
+        log->info("  Reused " + std::to_string(numReused) + " out of " + std::to_string(numSpectra)
+                  + " dust emission spectra from the previous iteration ("
+                  + StringUtils::toString(numSpectra ? 100. * numReused / numSpectra : 0., 'f', 1) + "%)");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustSecondarySource::launch(PhotonPacket* pp, size_t historyIndex, double L) const
+{
+    // select the spatial cell from which to launch based on the history index of this photon packet
+    auto p = std::upper_bound(_Iv.cbegin(), _Iv.cend(), historyIndex) - _Iv.cbegin() - 1;
+    auto m = _mv[p];
+
+    // calculate the weight related to biased source selection
+    double ws = _Lv[m] / _Wv[m];
+
+    // generate a random wavelength from the emission spectrum for the cell and/or from the bias distribution,
+    // and obtain the bulk velocity for the cell
+    double lambda, w;
+    VelocityInterface* velocity = nullptr;
+    if (_hasPrecomputedSpectra)
+    {
+        // use the precomputed emission spectrum for this cell
+        size_t offset = static_cast<size_t>(_sv[m]) * _numLambda;
+        PrecomputedSpectrum spectrum(_lambdav, &_pvv[offset], &_Pvv[offset]);
+        generateBiasedWavelength(spectrum, _config, _random, lambda, w);
+        t_velocity.setBulkVelocity(_ms->bulkVelocity(m));
+        velocity = &t_velocity;
+    }
+    else
+    {
+        // calculate the emission spectrum and bulk velocity for this cell, if not already available
+        t_dustcell.calculateIfNeeded(p, _mv, _nv, _ms, _config);
+        generateBiasedWavelength(t_dustcell, _config, _random, lambda, w);
+        velocity = &t_dustcell;
+    }
+
     // generate a random position in this spatial cell
     Position bfr = _ms->grid()->randomPositionInCell(m);
 
     // provide a redshift interface for the appropriate velocity, if it is nonzero
-    VelocityInterface* bvi = t_dustcell.velocity().isNull() ? nullptr : &t_dustcell;
+    VelocityInterface* bvi = velocity->velocity().isNull() ? nullptr : velocity;
 
     // provide a polarisation interface for polarised emission, if applicable
     // generate a random emission direction
@@ -32,7 +32,9 @@ public:
 
 public:
     /** This function calculates and stores the bolometric dust luminosities in each spatial cell
-        of the simulation, and returns the total bolometric dust luminosity. */
+        of the simulation, and returns the total bolometric dust luminosity. If so requested by
+        the configuration, it also precalculates the normalized emission spectra for all emitting
+        spatial cells, as described for the launch() function. */
     double prepareLuminosities() override;
 
     /** This function prepares the mapping of history indices to spatial cells, given the range of
@@ -58,6 +60,13 @@ public:
         requirements are limited to storing the information for only a single cell per execution
         thread, and the calculation is still performed only once per cell.
 
+        Alternatively, if the configuration requests precomputed dust emission spectra and the
+        required memory fits within the configured budget, the prepareLuminosities() function
+        calculates the normalized emission spectra for all emitting cells in advance, in parallel,
+        and stores them in single precision. If there is a single dust medium component, a spectrum
+        is stored for each library entry; otherwise a spectrum is stored for each cell. In this
+        case, the launch() function merely samples from the precomputed spectrum for the cell.
+
         Once the emission spectrum for the current cell is known, the function randomly generates a
         wavelength either from this emission spectrum or from the configured bias wavelength
         distribution, adjusting the launch weight with the proper bias factor. It then generates a
@@ -72,6 +81,21 @@ public:
         Finally, the function actually initializes the photon packet with this information. */
     void launch(PhotonPacket* pp, size_t historyIndex, double L) const override;
 
+private:
+    /** This function calculates the normalized emission spectra for all emitting spatial cells and
+        stores them in single precision, if the required memory fits within the configured budget.
+        Otherwise, it issues a warning and leaves the spectra to be calculated on the fly.
+
+        If the configuration requests reuse of the spectra, the function also stores the radiation
+        field from which each spectrum is calculated and the revision number of the medium state at
+        that time. When the function is called again in a subsequent secondary emission iteration,
+        it copies the spectrum calculated in the previous iteration for the same cell, rather than
+        recalculating it, if the relative change in the corresponding radiation field is below the
+        configured tolerance and the medium state of the cell (e.g., the dust densities) has not
+        been changed by a dynamic medium state update in the meantime. The function logs the
+        fraction of reused spectra. */
+    void precomputeSpectra();
+
     //======================== Data Members ========================
 
 private:
@@ -84,6 +108,17 @@ private:
     vector<int> _nv;     // the library entry index corresponding to each spatial cell (i.e. map from cells to entries)
     vector<int> _mv;     // the spatial cell indices sorted so that cells belonging to the same entry are consecutive
     vector<size_t> _Iv;  // first history index allocated to each spatial cell (with extra entry at the end)
+
+    // initialized by precomputeSpectra(), if enabled
+    bool _hasPrecomputedSpectra{false};
+    Array _lambdav;          // the wavelength grid for the precomputed spectra (indexed on ell)
+    int _numLambda{0};       // the number of wavelengths in the precomputed spectra
+    vector<int> _sv;         // the precomputed spectrum index for each spatial cell, or -1 if not emitting
+    vector<float> _pvv;      // the normalized emission spectra (indexed on s * _numLambda + ell)
+    vector<float> _Pvv;      // the normalized cumulative emission spectra (indexed on s * _numLambda + ell)
+    int _numFieldLambda{0};  // the number of wavelengths in the radiation fields used for the spectra
+    vector<float> _Jvv;      // the radiation field for each spectrum, if reused (indexed on s * _numFieldLambda + ell)
+    vector<int> _revisionv;  // the medium state revision for each spectrum, if reused (indexed on s)
 };
 
 ////////////////////////////////////////////////////////////////
@@ -215,7 +215,9 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
     double wavelength = pp->wavelength() * (1. + _redshift);
 
     // get the wavelength bin indices that overlap the photon packet wavelength and perform recording for each
-    for (int ell : _lambdagrid->bins(wavelength))
+    WavelengthGrid::BinList ellv;
+    _lambdagrid->bins(wavelength, ellv);
+    for (int ell : ellv)
     {
         // get the luminosity contribution from the photon packet,
         // taking into account the transmission for the detector bin at this wavelength
@@ -0,0 +1,340 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "GridCache.hpp"
+#include "BoolPropertyHandler.hpp"
+#include "Configuration.hpp"
+#include "DoubleListPropertyHandler.hpp"
+#include "DoublePropertyHandler.hpp"
+#include "EnumPropertyHandler.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
+#include "IntPropertyHandler.hpp"
+#include "ItemListPropertyHandler.hpp"
+#include "ItemPropertyHandler.hpp"
+#include "Log.hpp"
+#include "ProcessManager.hpp"
+#include "PropertyHandlerVisitor.hpp"
+#include "SchemaDef.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "StringPropertyHandler.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <cstdio>
+#include <fstream>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the alternate interpretations for 8-byte items in the grid cache format
+    union CacheItem
+    {
+        double doubleType;
+        size_t sizeType;
+        char stringType[8];
+    };
+    const size_t itemSize = sizeof(CacheItem);
+
+    static_assert((sizeof(size_t) == 8) & (sizeof(double) == 8) & (itemSize == 8),
+                  "Cannot properly declare union for items in grid cache format");
+
+    // the tags used in the grid cache format
+    const char* nameTag = "SKIRT G\n";
+    const char* endTag = "GCACHEND";
+    const size_t endianTag = 0x010203040A0BFEFF;
+
+    // returns the number of 8-byte items needed to hold the specified number of bytes
+    size_t numItemsFor(size_t numBytes)
+    {
+        return (numBytes + itemSize - 1) / itemSize;
+    }
+
+    // returns the array name padded with spaces to a length of 8 characters
+    string paddedName(string name)
+    {
+        if (name.size() > itemSize) throw FATALERROR("Grid cache array name is too long: " + name);
+        return name + string(itemSize - name.size(), ' ');
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+GridCache::GridCache(const SimulationItem* item, string kind, uint64_t key) : _item(item), _key(key)
+{
+    if (item->find<Configuration>()->hasSpatialGridCache())
+    {
+        string keyString(16, '0');
+        for (int i = 15; i >= 0; --i, key >>= 4) keyString[i] = "0123456789abcdef"[key & 15];
+        _filePath = item->find<FilePaths>()->input(kind + "_" + keyString + ".sgc");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+GridCache::~GridCache()
+{
+    if (!_mappedPath.empty()) System::releaseMemoryMap(_mappedPath);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool GridCache::load()
+{
+    if (!isEnabled() || !System::isFile(_filePath)) return false;
+
+    // acquire a memory map for the file; the function returns zeros if the memory map cannot be created
+    // the map is released through its canonical path, which is the identifier used by the acquire function
+    auto map = System::acquireMemoryMap(_filePath);
+    if (!map.first) return false;
+    _mappedPath = System::canonicalPath(_filePath);
+    const CacheItem* currentItem = static_cast<const CacheItem*>(map.first);
+    const CacheItem* endItem = currentItem + map.second / itemSize;
+
+    // verify the name tag, the Endianness tag, and the key
+    if (map.second < 5 * itemSize || memcmp(nameTag, currentItem++->stringType, itemSize)
+        || currentItem++->sizeType != endianTag || currentItem++->sizeType != _key)
+    {
+        _item->find<Log>()->warning("Ignoring grid cache file with unexpected contents: " + _filePath);
+        return false;
+    }
+
+    // get the array information, verifying that the arrays fit inside the file
+    size_t numArrays = currentItem++->sizeType;
+    for (size_t i = 0; i != numArrays; ++i)
+    {
+        if (endItem - currentItem < 3) break;
+        ArrayInfo info;
+        info.name = StringUtils::squeeze(string(currentItem++->stringType, itemSize));
+        info.elementSize = currentItem++->sizeType;
+        info.numElements = currentItem++->sizeType;
+        info.data = currentItem;
+        size_t numItems = numItemsFor(info.elementSize * info.numElements);
+        if (static_cast<size_t>(endItem - currentItem) < numItems) break;
+        currentItem += numItems;
+        _arrays.push_back(info);
+    }
+
+    // verify the end-of-file tag
+    if (_arrays.size() != numArrays || currentItem == endItem || memcmp(endTag, currentItem->stringType, itemSize))
+    {
+        _arrays.clear();
+        _item->find<Log>()->warning("Ignoring truncated grid cache file: " + _filePath);
+        return false;
+    }
+
+    _item->find<Log>()->info("Loading spatial grid data structures from cache file " + _filePath);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+const void* GridCache::array(string name, size_t elementSize, size_t& numElements) const
+{
+    if (_mappedPath.empty()) throw FATALERROR("Grid cache file has not been loaded");
+    for (const auto& info : _arrays)
+    {
+        if (info.name == name)
+        {
+            if (info.elementSize != elementSize)
+                throw FATALERROR("Array " + name + " has unexpected element size in grid cache file " + _filePath);
+            numElements = info.numElements;
+            return info.data;
+        }
+    }
+    throw FATALERROR("Array " + name + " is not in grid cache file " + _filePath);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void GridCache::addArray(string name, size_t elementSize, size_t numElements, const void* data)
+{
+    _arrays.push_back({name, elementSize, numElements, data});
+}
+
+////////////////////////////////////////////////////////////////////
+
+void GridCache::save()
+{
+    if (!isEnabled() || !ProcessManager::isRoot()) return;
+
+    // write the file under a temporary name
+    string tempPath = _filePath + ".tmp";
+    {
+        std::ofstream out = System::ofstream(tempPath, false, true);
+        auto writeItem = [&out](const void* data) { out.write(static_cast<const char*>(data), itemSize); };
+        auto writeSize = [&writeItem](size_t value) { writeItem(&value); };
+
+        writeItem(nameTag);
+        writeSize(endianTag);
+        writeSize(_key);
+        writeSize(_arrays.size());
+        for (const auto& info : _arrays)
+        {
+            writeItem(paddedName(info.name).c_str());
+            writeSize(info.elementSize);
+            writeSize(info.numElements);
+            size_t numBytes = info.elementSize * info.numElements;
+            out.write(static_cast<const char*>(info.data), numBytes);
+            size_t numPadding = numItemsFor(numBytes) * itemSize - numBytes;
+            if (numPadding) out.write(string(numPadding, '\0').c_str(), numPadding);
+        }
+        writeItem(endTag);
+        out.close();
+
+        if (!out)
+        {
+            _item->find<Log>()->warning("Could not write grid cache file " + tempPath);
+            System::removeFile(tempPath);
+            return;
+        }
+    }
+
+    // rename the file so that other processes never see a partially written file
+    if (std::rename(tempPath.c_str(), _filePath.c_str()))
+    {
+        _item->find<Log>()->warning("Could not rename grid cache file " + tempPath);
+        System::removeFile(tempPath);
+        return;
+    }
+    _item->find<Log>()->info("Stored spatial grid data structures in cache file " + _filePath);
+}
+
+////////////////////////////////////////////////////////////////////
+
+uint64_t GridCache::initialHash()
+{
+    return 0xcbf29ce484222325;
+}
+
+////////////////////////////////////////////////////////////////////
+
+uint64_t GridCache::hash(uint64_t seed, const void* data, size_t numBytes)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i != numBytes; ++i)
+    {
+        seed ^= bytes[i];
+        seed *= 0x100000001b3;
+    }
+    return seed;
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // forward declaration; see function definition at the end of this anonymous namespace
+    uint64_t hashProperties(uint64_t seed, Item* item, const SchemaDef* schema, const FilePaths* filePaths);
+
+    // returns the hash value updated with the characters in the specified string, including a terminating zero
+    uint64_t hashString(uint64_t seed, string value)
+    {
+        return GridCache::hash(seed, value.c_str(), value.size() + 1);
+    }
+
+    // returns the hash value updated with the complete contents of the specified file, read in large chunks
+    uint64_t hashFile(uint64_t seed, string path)
+    {
+        std::ifstream in = System::ifstream(path, true);
+        if (!in) throw FATALERROR("Could not open input file " + path + " to calculate the grid cache key");
+        vector<char> buffer(1 << 20);
+        while (in)
+        {
+            in.read(buffer.data(), buffer.size());
+            seed = GridCache::hash(seed, buffer.data(), in.gcount());
+        }
+        return seed;
+    }
+
+    // the functions in this class are part of the visitor pattern initiated by the hashProperties() function;
+    // they update the hash value with the name and value of the specified property
+    class PropertyHasher : public PropertyHandlerVisitor
+    {
+    private:
+        const SchemaDef* _schema;
+        const FilePaths* _filePaths;
+        uint64_t& _hash;
+
+    public:
+        PropertyHasher(const SchemaDef* schema, const FilePaths* filePaths, uint64_t& hash)
+            : _schema(schema), _filePaths(filePaths), _hash(hash)
+        {}
+
+        void visitPropertyHandler(StringPropertyHandler* handler) override
+        {
+            string value = handler->value();
+            _hash = hashString(hashString(_hash, handler->name()), value);
+
+            // if the string names an input file, include the contents of the file
+            if (!value.empty())
+            {
+                string path = _filePaths->input(value);
+                if (System::isFile(path)) _hash = hashFile(_hash, path);
+            }
+        }
+
+        void visitPropertyHandler(BoolPropertyHandler* handler) override
+        {
+            _hash = hashString(hashString(_hash, handler->name()), StringUtils::toString(handler->value()));
+        }
+
+        void visitPropertyHandler(IntPropertyHandler* handler) override
+        {
+            _hash = hashString(hashString(_hash, handler->name()), StringUtils::toString(handler->value()));
+        }
+
+        void visitPropertyHandler(EnumPropertyHandler* handler) override
+        {
+            _hash = hashString(hashString(_hash, handler->name()), handler->value());
+        }
+
+        void visitPropertyHandler(DoublePropertyHandler* handler) override
+        {
+            _hash = hashString(hashString(_hash, handler->name()), handler->toString(handler->value()));
+        }
+
+        void visitPropertyHandler(DoubleListPropertyHandler* handler) override
+        {
+            _hash = hashString(hashString(_hash, handler->name()), handler->toString(handler->value()));
+        }
+
+        void visitPropertyHandler(ItemPropertyHandler* handler) override
+        {
+            _hash = hashString(_hash, handler->name());
+            if (handler->value()) _hash = hashProperties(_hash, handler->value(), _schema, _filePaths);
+        }
+
+        void visitPropertyHandler(ItemListPropertyHandler* handler) override
+        {
+            _hash = hashString(_hash, handler->name());
+            for (Item* item : handler->value()) _hash = hashProperties(_hash, item, _schema, _filePaths);
+        }
+    };
+
+    // this function recursively updates the hash value with the type and properties of the specified item
+    // and its children, by asking each of the properties to accept a PropertyHasher instance as a visitor
+    uint64_t hashProperties(uint64_t seed, Item* item, const SchemaDef* schema, const FilePaths* filePaths)
+    {
+        uint64_t hash = hashString(seed, item->type());
+        PropertyHasher propertyHasher(schema, filePaths, hash);
+        for (const string& property : schema->properties(item->type()))
+        {
+            auto handler = schema->createPropertyHandler(item, property, nullptr);
+            handler->acceptVisitor(&propertyHasher);
+        }
+        return hash;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+uint64_t GridCache::hashItem(uint64_t seed, const SimulationItem* item)
+{
+    return hashProperties(seed, const_cast<SimulationItem*>(item), SimulationItemRegistry::getSchemaDef(),
+                          item->find<FilePaths>());
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,193 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef GRIDCACHE_HPP
+#define GRIDCACHE_HPP
+
+#include "Basics.hpp"
+#include <cstdint>
+#include <cstring>
+class SimulationItem;
+
+////////////////////////////////////////////////////////////////////
+
+/** An instance of the GridCache class manages a binary file caching the data structures of a
+    spatial grid or tessellation that are expensive to construct, such as the flattened node
+    hierarchy of a tree grid or the cell geometry, neighbor lists and search structures of a
+    Voronoi tessellation. This allows subsequent simulations using the same grid (for example, in a
+    parameter sweep over instrument or material mix properties for the same hydrodynamical
+    snapshot) to load these data structures rather than rebuilding them.
+
+    Cache keys
+    ----------
+
+    Each cache file is identified by a 64-bit key provided by the client. The key must be a hash of
+    all information determining the cached data structures. For example, a Voronoi tessellation
+    uses the generating site positions and the domain extent, and a tree grid uses the
+    configuration of the grid and the media (including the contents of any imported files), the
+    number of density samples, and the random seed. The static hash() and
+    hashItem() functions help calculating such keys. The cache files are placed in the input
+    directory of the simulation, with a filename composed of a client-specified kind and the
+    hexadecimal representation of the key. As a result, simulations with a different key simply
+    use a different cache file, and obsolete cache files can be removed at will.
+
+    Caching is enabled by the user through the corresponding flag in the SamplingOptions. If it is
+    disabled, the isEnabled() function of a cache instance returns false and all other functions
+    do nothing.
+
+    Cache file format
+    -----------------
+
+    Similar to the SKIRT stored table and stored columns formats, a grid cache file is a sequence
+    of 8-byte data items, each of which is a string of 8 characters, a 64-bit unsigned integer or a
+    64-bit floating point value, in little-endian byte order. The file is read through a memory
+    map. The overall layout is as follows:
+        - SKIRT name/version tag
+        - Endianness tag
+        - cache key
+        - numArrays
+        - for each array:
+          - arrayName
+          - elementSize (in bytes)
+          - numElements
+          - array contents, padded with zeros to a multiple of 8 bytes
+        - end-of-file tag
+
+    The elements of an array can be of any trivially copyable type, including for example int,
+    double, Vec and Box. An array is always read into a vector of the same element type as the one
+    used for writing it. The cache file is first written under a temporary name and then renamed,
+    so that other processes never observe a partially written cache file. In a multi-process
+    environment, only the root process writes the cache file.
+*/
+class GridCache
+{
+    // ================== Constructing ==================
+
+public:
+    /** The constructor determines the path of the cache file for the specified kind and key,
+        provided that caching is enabled in the configuration of the simulation hierarchy
+        containing the specified item. The \em kind string is used as the first part of the
+        cache filename and should briefly describe the type of data structure being cached. */
+    GridCache(const SimulationItem* item, string kind, uint64_t key);
+
+    /** The destructor releases the memory map on the cache file, if there is one. */
+    ~GridCache();
+
+    /** The copy constructor is deleted because instances of this class should never be copied or
+        moved. */
+    GridCache(const GridCache&) = delete;
+
+    /** The assignment operator is deleted because instances of this class should never be copied
+        or moved. */
+    GridCache& operator=(const GridCache&) = delete;
+
+    /** This function returns true if caching is enabled, and false otherwise. */
+    bool isEnabled() const { return !_filePath.empty(); }
+
+    // ================== Loading ==================
+
+public:
+    /** This function attempts to acquire a memory map on the cache file. If caching is enabled and
+        a valid cache file with the appropriate key exists, the function logs a message and
+        returns true, and the arrays in the file can be retrieved using the get() function.
+        Otherwise the function returns false. */
+    bool load();
+
+    /** This function copies the contents of the array with the specified name from the cache file
+        into the specified vector, which is resized as needed. The function throws a fatal error if
+        the cache file has not been loaded, if it does not contain an array with the specified
+        name, or if the array element size differs from the size of the vector element type. */
+    template<class T> void get(string name, vector<T>& v) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Cached array elements must be trivially copyable");
+        size_t numElements;
+        const void* data = array(name, sizeof(T), numElements);
+        v.resize(numElements);
+        if (numElements) std::memcpy(static_cast<void*>(v.data()), data, numElements * sizeof(T));
+    }
+
+    // ================== Saving ==================
+
+public:
+    /** This function registers the specified vector as an array with the specified name (of at
+        most 8 characters) to be written to the cache file. The function does not copy the vector
+        contents, so the vector must remain alive and unchanged until the save() function has been
+        called. If caching is disabled, the function does nothing. */
+    template<class T> void put(string name, const vector<T>& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Cached array elements must be trivially copyable");
+        if (isEnabled()) addArray(name, sizeof(T), v.size(), v.data());
+    }
+
+    /** This function writes the arrays registered with the put() function to the cache file. If
+        caching is disabled, or if this is not the root process, the function does nothing. A
+        failure to write the cache file is reported as a warning rather than as a fatal error. */
+    void save();
+
+    // ================== Hashing ==================
+
+public:
+    /** This function returns the initial value for calculating a hash value using the hash()
+        functions. */
+    static uint64_t initialHash();
+
+    /** This function returns the hash value resulting from updating the specified hash value with
+        the specified number of bytes starting at the specified address, using the 64-bit
+        Fowler-Noll-Vo (FNV-1a) algorithm. */
+    static uint64_t hash(uint64_t seed, const void* data, size_t numBytes);
+
+    /** This function returns the hash value resulting from updating the specified hash value with
+        the binary representation of the specified value, which must be of a trivially copyable
+        type. */
+    template<class T> static uint64_t hash(uint64_t seed, const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Hashed values must be trivially copyable");
+        return hash(seed, &value, sizeof(T));
+    }
+
+    /** This function returns the hash value resulting from updating the specified hash value with
+        the configuration of the specified simulation item and all of its children, i.e. the item
+        types and property values as they would be written to a ski file. For string properties
+        that name an existing input file, the complete contents of that file are included in the
+        hash as well, so that any change to an imported snapshot invalidates the cache, regardless
+        of the file's modification time. For very large input files, reading the file to calculate
+        the hash takes a noticeable amount of time, which is still much shorter than the time
+        needed to import the file and construct the grid. */
+    static uint64_t hashItem(uint64_t seed, const SimulationItem* item);
+
+    // ================== Private helpers ==================
+
+private:
+    /** This function returns a pointer to the contents of the array with the specified name in the
+        loaded cache file, and stores the number of elements in \em numElements. It throws a fatal
+        error if the array is not present or if its element size differs from the specified size.
+        */
+    const void* array(string name, size_t elementSize, size_t& numElements) const;
+
+    /** This function registers the specified array to be written to the cache file. */
+    void addArray(string name, size_t elementSize, size_t numElements, const void* data);
+
+    // ================== Data members ==================
+
+private:
+    // information about an array in the cache file, or to be written to the cache file
+    struct ArrayInfo
+    {
+        string name;
+        size_t elementSize;
+        size_t numElements;
+        const void* data;
+    };
+
+    const SimulationItem* _item{nullptr};  // the simulation item used for logging
+    string _filePath;                      // the path to the cache file, or empty if caching is disabled
+    uint64_t _key{0};                      // the cache key
+    string _mappedPath;                    // the canonical path of the memory-mapped cache file, or empty
+    vector<ArrayInfo> _arrays;             // the arrays in the loaded cache file or to be written to it
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
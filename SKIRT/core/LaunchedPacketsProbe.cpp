@@ -50,7 +50,9 @@ void LaunchedPacketsProbe::initialize()
 void LaunchedPacketsProbe::probePhotonPacket(const PhotonPacket* pp)
 {
     // count the packet for each wavelength bin index
-    for (int ell : _probeWavelengthGrid->bins(pp->sourceRestFrameWavelength()))
+    WavelengthGrid::BinList ellv;
+    _probeWavelengthGrid->bins(pp->sourceRestFrameWavelength(), ellv);
+    for (int ell : ellv)
     {
         // get the source component index and register as a primary or secondary packet
         int h = pp->compIndex();
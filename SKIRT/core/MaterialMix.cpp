@@ -124,6 +124,27 @@ bool MaterialMix::isSpecificStateConverged(int /*numCells*/, int /*numUpdated*/,
 
 ////////////////////////////////////////////////////////////////////
 
+double MaterialMix::sectionAbsWithHint(double lambda, int& /*ell*/) const
+{
+    return sectionAbs(lambda);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MaterialMix::sectionScaWithHint(double lambda, int& /*ell*/) const
+{
+    return sectionSca(lambda);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MaterialMix::sectionExtWithHint(double lambda, int& /*ell*/) const
+{
+    return sectionExt(lambda);
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MaterialMix::asymmpar(double /*lambda*/) const
 {
     return 0.;
@@ -418,6 +418,23 @@ public:
         \varsigma^{\text{sca}}_{\lambda}\f$ at wavelength \f$\lambda\f$. */
     virtual double sectionExt(double lambda) const = 0;
 
+    /** This function returns the same value as sectionAbs(). The \em ell argument serves as a
+        cache for the index of the wavelength bin used by the most recent invocation for this
+        material mix. It should be initialized to -1 by the caller and then passed unchanged to
+        subsequent invocations. This allows implementations based on tabulated cross sections to
+        avoid a full search if the wavelength falls in the same bin as before, which is common
+        when the wavelength varies slightly along a path because of Doppler shifts. The default
+        implementation ignores the \em ell argument and simply calls sectionAbs(). */
+    virtual double sectionAbsWithHint(double lambda, int& ell) const;
+
+    /** This function returns the same value as sectionSca(), using the \em ell argument as a
+        cache for the wavelength bin index as described for sectionAbsWithHint(). */
+    virtual double sectionScaWithHint(double lambda, int& ell) const;
+
+    /** This function returns the same value as sectionExt(), using the \em ell argument as a
+        cache for the wavelength bin index as described for sectionAbsWithHint(). */
+    virtual double sectionExtWithHint(double lambda, int& ell) const;
+
     /** This function returns the default scattering asymmetry parameter \f$g_\lambda =
         \left<\cos\theta\right>\f$ at wavelength \f$\lambda\f$. This value serves as a parameter
         for the Henyey-Greenstein phase function. The default implementation in this base class
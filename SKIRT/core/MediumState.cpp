@@ -77,8 +77,16 @@ size_t MediumState::initAllocate()
     if (_nextComponent != _numMedia) throw FATALERROR("Failed to request state variables for all medium components");
     _numVars = _nextOffset;
 
+    // determine whether the number densities for all media are stored at evenly spaced offsets
+    int stride = _numMedia > 1 ? _off_dens[1] - _off_dens[0] : 1;
+    bool even = stride > 0;
+    for (int h = 1; h < _numMedia; ++h)
+        if (_off_dens[h] - _off_dens[h - 1] != stride) even = false;
+    _stride_dens = even ? stride : 0;
+
     size_t numAlloc = static_cast<size_t>(_numVars) * static_cast<size_t>(_numCells);
     _data.resize(numAlloc);
+    _revisionv.resize(_numCells);
     return numAlloc;
 }
 
@@ -95,6 +103,7 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
 {
     int numUpdated = 0;
     int numNotConverged = 0;
+    _revision++;
 
     if (ProcessManager::isMultiProc())
     {
@@ -109,6 +118,7 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
                     double* first = &_data[_numVars * m];
                     data.insert(data.end(), first, first + _numVars);
                     // update status
+                    _revisionv[m] = _revision;
                     numUpdated++;
                     if (cellFlags[m].isConverged())
                     {
@@ -130,6 +140,7 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
                 // state variables
                 std::copy(in + 1, in + 1 + _numVars, &_data[_numVars * m]);
                 // update status
+                _revisionv[m] = _revision;
                 numUpdated++;
                 if (*(in + 1 + _numVars)) numNotConverged++;
             }
@@ -140,7 +151,11 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
     {
         for (int m = 0; m != _numCells; ++m)
         {
-            if (cellFlags[m].isUpdated()) numUpdated++;
+            if (cellFlags[m].isUpdated())
+            {
+                _revisionv[m] = _revision;
+                numUpdated++;
+            }
             if (!cellFlags[m].isConverged()) numNotConverged++;
         }
     }
@@ -128,7 +128,11 @@ public:
 
         Only one of the calling processes may have updated the state for any given cell. If two or
         more processes updated the state of the same cell, the result of the synchronization is
-        undefined. */
+        undefined.
+
+        Each invocation of this function increments the overall revision number of the medium
+        state, and marks the cells that have been updated by any of the processes with this new
+        revision number (see the revision() functions). */
     std::pair<int, int> synchronize(const vector<UpdateStatus>& cellFlags);
 
     //============= Setting =============
@@ -196,6 +200,28 @@ public:
         spatial cell with index \f$m\f$. */
     double numberDensity(int m, int h) const { return _data[_numVars * m + _off_dens[h]]; }
 
+    /** This function returns the weighted sum \f$\sum_h w_h\,n_{m,h}\f$ over all medium
+        components of the number density in the spatial cell with index \f$m\f$, using the
+        specified weights \f$w_h\f$, which usually are cross sections. In the common case where
+        the number densities of all medium components are stored at evenly spaced offsets, the
+        loop uses a constant stride rather than an offset table, allowing the compiler to
+        vectorize it. */
+    double weightedNumberDensity(int m, const double* weightv) const
+    {
+        const double* cell = &_data[_numVars * m];
+        double result = 0.;
+        if (_stride_dens)
+        {
+            const double* densv = cell + _off_dens[0];
+            for (int h = 0; h != _numMedia; ++h) result += weightv[h] * densv[h * _stride_dens];
+        }
+        else
+        {
+            for (int h = 0; h != _numMedia; ++h) result += weightv[h] * cell[_off_dens[h]];
+        }
+        return result;
+    }
+
     /** This function returns the metallicity \f$Z\f$ of the medium component with index \f$h\f$ in
         the spatial cell with index \f$m\f$. */
     double metallicity(int m, int h) const { return _data[_numVars * m + _off_meta[h]]; }
@@ -208,12 +234,31 @@ public:
         component with index \f$h\f$ in the spatial cell with index \f$m\f$. */
     double custom(int m, int h, int i) const { return _data[_numVars * m + _off_cust[h] + i]; }
 
+    //============= Revisions =============
+
+public:
+    /** This function returns the overall revision number of the medium state, i.e. the number of
+        times the synchronize() function has been called. The revision number is zero after
+        initialization. */
+    int revision() const { return _revision; }
+
+    /** This function returns the revision number of the medium state in the spatial cell with
+        index \f$m\f$, i.e. the overall revision number at the time the state of the cell was last
+        updated, or zero if the state of the cell has not been updated since initialization. This
+        allows a client to determine whether the state of a cell has changed since some earlier
+        point in time without keeping a copy of all state variables. */
+    int revision(int m) const { return _revisionv[m]; }
+
     //======================== Data Members ========================
 
 private:
     // data array containing the medium state variables
     Array _data;
 
+    // overall revision number and revision number for each cell
+    int _revision{0};
+    vector<int> _revisionv;
+
     // configuration and offsets used for mapping to indices in the data array
     int _numCells{0};
     int _numMedia{0};
@@ -225,6 +270,7 @@ private:
     vector<int> _off_meta;
     vector<int> _off_temp;
     vector<int> _off_cust;
+    int _stride_dens{0};  // stride between number density offsets if evenly spaced, or zero otherwise
 
     // indices indicating the next item to be initialized; used only during initialization
     int _nextOffset{0};
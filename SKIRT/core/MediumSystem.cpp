@@ -189,6 +189,7 @@ void MediumSystem::setupSelfAfter()
     auto log = find<Log>();
     auto parfac = find<ParallelFactory>();
     _config = find<Configuration>();
+    _random = find<Random>();
 
     _numCells = _grid->numCells();
     if (_numCells < 1) throw FATALERROR("The spatial grid must have at least one cell");
@@ -229,6 +230,33 @@ void MediumSystem::setupSelfAfter()
         }
     }
 
+    // ----- decide on the radiation field accumulation strategy -----
+
+    if (_config->hasRadiationField() && _config->hasPerThreadRadiationField())
+    {
+        // estimate the worst-case memory requirement, i.e. when each thread touches every cell
+        int numThreads = parfac->maxThreadCount();
+        double bufferBytes = static_cast<double>(_rf1.size()) * sizeof(double) * numThreads;
+        if (numThreads < 2)
+        {
+            log->info("Using atomic radiation field accumulation because there is only a single thread");
+        }
+        else if (bufferBytes > _config->maxRadiationFieldBufferMemory())
+        {
+            log->warning("Using atomic radiation field accumulation because per-thread buffers could require up to "
+                         + StringUtils::toMemSizeString(bufferBytes) + " of memory");
+        }
+        else
+        {
+            _hasRadiationFieldBuffers = true;
+            log->info("Using per-thread radiation field buffers requiring at most "
+                      + StringUtils::toMemSizeString(bufferBytes) + " of memory");
+
+            // discard any buffers left behind by a previous medium system that lived at the same address
+            for (auto buffer : _rfBuffers.all()) *buffer = RadiationFieldBuffer();
+        }
+    }
+
     // ----- cache info on the dust emission wavelength grid -----
 
     if (_config->hasDustEmission())
@@ -842,200 +870,321 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
-void MediumSystem::setExtinctionOpticalDepths(PhotonPacket* pp) const
-{
-    // determine and store the path segments in the photon packet
-    auto generator = getPathSegmentGenerator(_grid, pp);
-    pp->clear();
-    while (generator->next())
-    {
-        pp->addSegment(generator->m(), generator->ds());
-    }
+// The optical depth calculations in the functions below are expressed in terms of an opacity kernel, i.e. an object
+// that offers the following two functions for a spatial cell with index m at a distance s along the path of the
+// photon packet being handled:
+//     double opacityExt(int m, double s);
+//     void opacityScaAbs(int m, double s, double& ksca, double& kabs);
+// The withOpacityKernel() function constructs the kernel that is most efficient for the current configuration and
+// passes it to the specified function, which is usually a generic lambda. As a result, the loop over the path
+// segments is compiled separately for each kernel type, avoiding any configuration tests inside the loop.
+// The constructor of each kernel precalculates only the quantities required by the caller, as indicated by the
+// scaAbs flag (scattering and absorption if true, extinction if false).
 
-    // calculate the cumulative optical depth and store it in the photon packet for each path segment
-    double tau = 0.;
+// single medium, spatially constant cross sections
+class MediumSystem::SingleSectionKernel
+{
+    const MediumState& _state;
+    double _sectionExt{0.};
+    double _sectionSca{0.};
+    double _sectionAbs{0.};
 
-    // single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
+public:
+    SingleSectionKernel(const MediumSystem* ms, const PhotonPacket* pp, bool scaAbs) : _state(ms->_state)
     {
-        double section = mix(0, 0)->sectionExt(pp->wavelength());
-        for (auto& segment : pp->segments())
+        if (scaAbs)
+        {
+            _sectionSca = ms->mix(0, 0)->sectionSca(pp->wavelength());
+            _sectionAbs = ms->mix(0, 0)->sectionAbs(pp->wavelength());
+        }
+        else
         {
-            if (segment.m() >= 0) tau += section * _state.numberDensity(segment.m(), 0) * segment.ds();
-            segment.setOpticalDepth(tau);
+            _sectionExt = ms->mix(0, 0)->sectionExt(pp->wavelength());
         }
     }
 
-    // multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
+    double opacityExt(int m, double /*s*/) { return _sectionExt * _state.numberDensity(m, 0); }
+
+    void opacityScaAbs(int m, double /*s*/, double& ksca, double& kabs)
     {
-        ShortArray sectionv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
-        for (auto& segment : pp->segments())
-        {
-            if (segment.m() >= 0)
-                for (int h = 0; h != _numMedia; ++h)
-                    tau += sectionv[h] * _state.numberDensity(segment.m(), h) * segment.ds();
-            segment.setOpticalDepth(tau);
-        }
+        double n = _state.numberDensity(m, 0);
+        ksca = _sectionSca * n;
+        kabs = _sectionAbs * n;
     }
+};
 
-    // spatially variable cross sections
-    else
+////////////////////////////////////////////////////////////////////
+
+// multiple media, spatially constant cross sections
+class MediumSystem::MultipleSectionKernel
+{
+    const MediumState& _state;
+    ShortArray _sectionExtv;
+    ShortArray _sectionScav;
+    ShortArray _sectionAbsv;
+
+public:
+    MultipleSectionKernel(const MediumSystem* ms, const PhotonPacket* pp, bool scaAbs) : _state(ms->_state)
     {
-        for (auto& segment : pp->segments())
+        int numMedia = ms->_numMedia;
+        if (scaAbs)
         {
-            if (segment.m() >= 0)
+            _sectionScav.resize(numMedia);
+            _sectionAbsv.resize(numMedia);
+            for (int h = 0; h != numMedia; ++h)
             {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(segment.m()),
-                                                        _config->hubbleExpansionRate() * segment.s());
-                tau += opacityExt(lambda, segment.m(), pp) * segment.ds();
+                _sectionScav[h] = ms->mix(0, h)->sectionSca(pp->wavelength());
+                _sectionAbsv[h] = ms->mix(0, h)->sectionAbs(pp->wavelength());
             }
-            segment.setOpticalDepth(tau);
+        }
+        else
+        {
+            _sectionExtv.resize(numMedia);
+            for (int h = 0; h != numMedia; ++h) _sectionExtv[h] = ms->mix(0, h)->sectionExt(pp->wavelength());
         }
     }
-}
 
-////////////////////////////////////////////////////////////////////
+    double opacityExt(int m, double /*s*/) { return _state.weightedNumberDensity(m, &_sectionExtv[0]); }
 
-void MediumSystem::setScatteringAndAbsorptionOpticalDepths(PhotonPacket* pp) const
-{
-    // determine and store the path segments in the photon packet
-    auto generator = getPathSegmentGenerator(_grid, pp);
-    pp->clear();
-    while (generator->next())
+    void opacityScaAbs(int m, double /*s*/, double& ksca, double& kabs)
     {
-        pp->addSegment(generator->m(), generator->ds());
+        ksca = _state.weightedNumberDensity(m, &_sectionScav[0]);
+        kabs = _state.weightedNumberDensity(m, &_sectionAbsv[0]);
     }
+};
 
-    // calculate the cumulative optical depths and store them in the photon packet for each path segment
-    double tauSca = 0.;
-    double tauAbs = 0.;
+////////////////////////////////////////////////////////////////////
 
-    // single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
+// one or more media, cross sections depending only on the perceived wavelength, which varies between cells;
+// the kernel remembers the most recent wavelength bin index for each medium so that the material mix can
+// skip the bin search as long as the perceived wavelength stays within the same bin
+class MediumSystem::ShiftedSectionKernel
+{
+    const MediumState& _state;
+    const MediumSystem* _ms;
+    const PhotonPacket* _pp;
+    double _expansionRate;
+    int _numMedia;
+    int _inlineEllv[ShortArray::N];
+    vector<int> _heapEllv;
+    int* _ellv;
+
+public:
+    ShiftedSectionKernel(const MediumSystem* ms, const PhotonPacket* pp, bool /*scaAbs*/)
+        : _state(ms->_state), _ms(ms), _pp(pp), _expansionRate(ms->_config->hubbleExpansionRate()),
+          _numMedia(ms->_numMedia)
     {
-        double sectionSca = mix(0, 0)->sectionSca(pp->wavelength());
-        double sectionAbs = mix(0, 0)->sectionAbs(pp->wavelength());
-        for (auto& segment : pp->segments())
+        if (_numMedia > ShortArray::N)
         {
-            if (segment.m() >= 0)
-            {
-                double ns = _state.numberDensity(segment.m(), 0) * segment.ds();
-                tauSca += sectionSca * ns;
-                tauAbs += sectionAbs * ns;
-            }
-            segment.setOpticalDepth(tauSca, tauAbs);
+            _heapEllv.resize(_numMedia);
+            _ellv = _heapEllv.data();
+        }
+        else
+        {
+            _ellv = _inlineEllv;
         }
+        for (int h = 0; h != _numMedia; ++h) _ellv[h] = -1;
     }
 
-    // multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
+    double opacityExt(int m, double s)
     {
-        ShortArray sectionScav(_numMedia);
-        ShortArray sectionAbsv(_numMedia);
+        double lambda = _pp->perceivedWavelength(_state.bulkVelocity(m), _expansionRate * s);
+        double result = 0.;
+        for (int h = 0; h != _numMedia; ++h)
+            result += _ms->mix(0, h)->sectionExtWithHint(lambda, _ellv[h]) * _state.numberDensity(m, h);
+        return result;
+    }
+
+    void opacityScaAbs(int m, double s, double& ksca, double& kabs)
+    {
+        double lambda = _pp->perceivedWavelength(_state.bulkVelocity(m), _expansionRate * s);
+        ksca = 0.;
+        kabs = 0.;
         for (int h = 0; h != _numMedia; ++h)
         {
-            sectionScav[h] = mix(0, h)->sectionSca(pp->wavelength());
-            sectionAbsv[h] = mix(0, h)->sectionAbs(pp->wavelength());
-        }
-        for (auto& segment : pp->segments())
-        {
-            if (segment.m() >= 0)
-                for (int h = 0; h != _numMedia; ++h)
-                {
-                    double ns = _state.numberDensity(segment.m(), h) * segment.ds();
-                    tauSca += sectionScav[h] * ns;
-                    tauAbs += sectionAbsv[h] * ns;
-                }
-            segment.setOpticalDepth(tauSca, tauAbs);
+            const MaterialMix* mix = _ms->mix(0, h);
+            double n = _state.numberDensity(m, h);
+            ksca += mix->sectionScaWithHint(lambda, _ellv[h]) * n;
+            kabs += mix->sectionAbsWithHint(lambda, _ellv[h]) * n;
         }
     }
+};
 
-    // spatially variable cross sections
+////////////////////////////////////////////////////////////////////
+
+// spatially variable cross sections
+class MediumSystem::VariableSectionKernel
+{
+    const MediumState& _state;
+    const MediumSystem* _ms;
+    const PhotonPacket* _pp;
+    double _expansionRate;
+
+public:
+    VariableSectionKernel(const MediumSystem* ms, const PhotonPacket* pp, bool /*scaAbs*/)
+        : _state(ms->_state), _ms(ms), _pp(pp), _expansionRate(ms->_config->hubbleExpansionRate())
+    {}
+
+    double opacityExt(int m, double s)
+    {
+        double lambda = _pp->perceivedWavelength(_state.bulkVelocity(m), _expansionRate * s);
+        return _ms->opacityExt(lambda, m, _pp);
+    }
+
+    void opacityScaAbs(int m, double s, double& ksca, double& kabs)
+    {
+        double lambda = _pp->perceivedWavelength(_state.bulkVelocity(m), _expansionRate * s);
+        ksca = _ms->opacitySca(lambda, m, _pp);
+        kabs = _ms->opacityAbs(lambda, m, _pp);
+    }
+};
+
+////////////////////////////////////////////////////////////////////
+
+template<class Function> void MediumSystem::withOpacityKernel(const PhotonPacket* pp, bool scaAbs, Function fn) const
+{
+    if (_config->hasSingleConstantSectionMedium())
+    {
+        SingleSectionKernel kernel(this, pp, scaAbs);
+        fn(kernel);
+    }
+    else if (_config->hasMultipleConstantSectionMedia())
+    {
+        MultipleSectionKernel kernel(this, pp, scaAbs);
+        fn(kernel);
+    }
+    else if (_config->hasShiftedConstantSectionMedia())
+    {
+        ShiftedSectionKernel kernel(this, pp, scaAbs);
+        fn(kernel);
+    }
     else
     {
-        for (auto& segment : pp->segments())
-        {
-            if (segment.m() >= 0)
-            {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(segment.m()),
-                                                        _config->hubbleExpansionRate() * segment.s());
-                tauSca += opacitySca(lambda, segment.m(), pp) * segment.ds();
-                tauAbs += opacityAbs(lambda, segment.m(), pp) * segment.ds();
-            }
-            segment.setOpticalDepth(tauSca, tauAbs);
-        }
+        VariableSectionKernel kernel(this, pp, scaAbs);
+        fn(kernel);
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
-bool MediumSystem::setInteractionPointUsingExtinction(PhotonPacket* pp, double tauinteract) const
+void MediumSystem::setExtinctionOpticalDepths(PhotonPacket* pp) const
 {
+    // determine and store the path segments in the photon packet
     auto generator = getPathSegmentGenerator(_grid, pp);
-    double tau = 0.;
-    double s = 0.;
+    pp->clear();
+    while (generator->next())
+    {
+        pp->addSegment(generator->m(), generator->ds());
+    }
 
-    // loop over the segments of the path until the interaction optical depth is reached or the path ends
+    // calculate the cumulative optical depth and store it in the photon packet for each path segment
+    withOpacityKernel(pp, false, [pp](auto& kernel) {
+        double tau = 0.;
+        double s = 0.;
+        size_t numSegments = pp->numSegments();
+        for (size_t i = 0; i != numSegments; ++i)
+        {
+            int m = pp->m(i);
+            double ds = pp->ds(i);
+            s += ds;
+            if (m >= 0) tau += kernel.opacityExt(m, s) * ds;
+            pp->addOpticalDepth(tau);
+        }
+    });
+}
 
-    // --> single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::setScatteringAndAbsorptionOpticalDepths(PhotonPacket* pp) const
+{
+    // determine and store the path segments in the photon packet
+    auto generator = getPathSegmentGenerator(_grid, pp);
+    pp->clear();
+    while (generator->next())
     {
-        double section = mix(0, 0)->sectionExt(pp->wavelength());
-        while (generator->next())
-        {
-            // remember the cumulative optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tau0 = tau;
-            double s0 = s;
+        pp->addSegment(generator->m(), generator->ds());
+    }
 
-            // calculate the cumulative optical depth and distance at the end of this segment
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0) tau += section * _state.numberDensity(m, 0) * generator->ds();
+    // calculate the cumulative optical depths and store them in the photon packet for each path segment
+    withOpacityKernel(pp, true, [pp](auto& kernel) {
+        double tauSca = 0.;
+        double tauAbs = 0.;
+        double s = 0.;
+        size_t numSegments = pp->numSegments();
+        for (size_t i = 0; i != numSegments; ++i)
+        {
+            int m = pp->m(i);
+            double ds = pp->ds(i);
             s += ds;
-
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauinteract < tau)
+            if (m >= 0)
             {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauinteract, tau0, tau, s0, s));
-                return true;
+                double ksca, kabs;
+                kernel.opacityScaAbs(m, s, ksca, kabs);
+                tauSca += ksca * ds;
+                tauAbs += kabs * ds;
             }
+            pp->addOpticalDepth(tauSca, tauAbs);
         }
-    }
+    });
+}
 
-    // --> multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
-    {
-        ShortArray sectionv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
+////////////////////////////////////////////////////////////////////
+
+double MediumSystem::streamOpticalDepths(
+    PhotonPacket* pp, const std::function<void(int m, double ds, double s, double tauExt)>& visit) const
+{
+    bool scaAbs = _config->explicitAbsorption();
+    auto generator = getPathSegmentGenerator(_grid, pp);
+    pp->clear();
+
+    // walk the path, calculating the cumulative optical depths and passing them to the visitor
+    double tauExtOrSca = 0.;
+    double tauAbs = 0.;
+    double s = 0.;
+    int mlast = -1;
+    withOpacityKernel(pp, scaAbs, [scaAbs, generator, &visit, &tauExtOrSca, &tauAbs, &s, &mlast](auto& kernel) {
         while (generator->next())
         {
-            // remember the cumulative optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tau0 = tau;
-            double s0 = s;
-
-            // calculate the cumulative optical depth and distance at the end of this segment
-            double ds = generator->ds();
             int m = generator->m();
+            double ds = generator->ds();
+            // evaluate the opacity at the distance where the segment starts, as do the functions that subsequently
+            // walk the path to locate the interaction point, so that both walks produce identical optical depths
+            mlast = m;
             if (m >= 0)
-                for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * _state.numberDensity(m, h) * ds;
-            s += ds;
-
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauinteract < tau)
             {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauinteract, tau0, tau, s0, s));
-                return true;
+                if (scaAbs)
+                {
+                    double ksca, kabs;
+                    kernel.opacityScaAbs(m, s, ksca, kabs);
+                    tauExtOrSca += ksca * ds;
+                    tauAbs += kabs * ds;
+                }
+                else
+                {
+                    tauExtOrSca += kernel.opacityExt(m, s) * ds;
+                }
             }
+            s += ds;
+            if (m >= 0 && visit) visit(m, ds, s, tauExtOrSca + tauAbs);
         }
-    }
+    });
 
-    // --> spatially variable cross sections
-    else
-    {
+    // set the interaction point to the end of the path as a fallback
+    pp->setInteractionPoint(mlast, s, tauAbs);
+    return tauExtOrSca;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MediumSystem::setInteractionPointUsingExtinction(PhotonPacket* pp, double tauinteract) const
+{
+    auto generator = getPathSegmentGenerator(_grid, pp);
+    bool found = false;
+
+    // loop over the segments of the path until the interaction optical depth is reached or the path ends
+    withOpacityKernel(pp, false, [pp, tauinteract, generator, &found](auto& kernel) {
+        double tau = 0.;
+        double s = 0.;
         while (generator->next())
         {
             // remember the cumulative optical depth and distance at the start of this segment
@@ -1046,24 +1195,21 @@ bool MediumSystem::setInteractionPointUsingExtinction(PhotonPacket* pp, double t
             // calculate the cumulative optical depth and distance at the end of this segment
             double ds = generator->ds();
             int m = generator->m();
-            if (m >= 0)
-            {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
-                tau += opacityExt(lambda, m, pp) * ds;
-            }
+            if (m >= 0) tau += kernel.opacityExt(m, s) * ds;
             s += ds;
 
             // if the interaction point is inside this segment, store it in the photon packet
             if (tauinteract < tau)
             {
                 pp->setInteractionPoint(m, NR::interpolateLinLin(tauinteract, tau0, tau, s0, s));
-                return true;
+                found = true;
+                return;
             }
         }
-    }
+    });
 
-    // the interaction point is outside of the path
-    return false;
+    // if the loop ended without finding the interaction point, it is outside of the path
+    return found;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1071,69 +1217,30 @@ bool MediumSystem::setInteractionPointUsingExtinction(PhotonPacket* pp, double t
 bool MediumSystem::setInteractionPointUsingScatteringAndAbsorption(PhotonPacket* pp, double tauinteract) const
 {
     auto generator = getPathSegmentGenerator(_grid, pp);
-    double tauSca = 0.;
-    double tauAbs = 0.;
-    double s = 0.;
+    bool found = false;
 
     // loop over the segments of the path until the interaction optical depth is reached or the path ends
-
-    // --> single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
-    {
-        double sectionSca = mix(0, 0)->sectionSca(pp->wavelength());
-        double sectionAbs = mix(0, 0)->sectionAbs(pp->wavelength());
+    withOpacityKernel(pp, true, [pp, tauinteract, generator, &found](auto& kernel) {
+        double tauSca = 0.;
+        double tauAbs = 0.;
+        double s = 0.;
         while (generator->next())
         {
-            // remember the cumulative scattering optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tauSca0 = tauSca;
-            double s0 = s;
-
-            // calculate the cumulative optical depths and distance at the end of this segment
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0) tauSca += sectionSca * _state.numberDensity(m, 0) * generator->ds();
-            s += ds;
-
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauinteract < tauSca)
-            {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauinteract, tauSca0, tauSca, s0, s),
-                                        tauinteract * sectionAbs / sectionSca);
-                return true;
-            }
-        }
-    }
-
-    // --> multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
-    {
-        ShortArray sectionScav(_numMedia);
-        ShortArray sectionAbsv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h)
-        {
-            sectionScav[h] = mix(0, h)->sectionSca(pp->wavelength());
-            sectionAbsv[h] = mix(0, h)->sectionAbs(pp->wavelength());
-        }
-        while (generator->next())
-        {
-            // remember the cumulative optical depth and distance at the start of this segment
+            // remember the cumulative optical depths and distance at the start of this segment
             // so that we can interpolate the interaction point should it happen to be inside this segment
             double tauSca0 = tauSca;
             double tauAbs0 = tauAbs;
             double s0 = s;
 
-            // calculate the cumulative optical depth and distance at the end of this segment
+            // calculate the cumulative optical depths and distance at the end of this segment
             double ds = generator->ds();
             int m = generator->m();
             if (m >= 0)
             {
-                for (int h = 0; h != _numMedia; ++h)
-                {
-                    double ns = _state.numberDensity(m, h) * ds;
-                    tauSca += sectionScav[h] * ns;
-                    tauAbs += sectionAbsv[h] * ns;
-                }
+                double ksca, kabs;
+                kernel.opacityScaAbs(m, s, ksca, kabs);
+                tauSca += ksca * ds;
+                tauAbs += kabs * ds;
             }
             s += ds;
 
@@ -1142,45 +1249,80 @@ bool MediumSystem::setInteractionPointUsingScatteringAndAbsorption(PhotonPacket*
             {
                 pp->setInteractionPoint(m, NR::interpolateLinLin(tauinteract, tauSca0, tauSca, s0, s),
                                         NR::interpolateLinLin(tauinteract, tauSca0, tauSca, tauAbs0, tauAbs));
-                return true;
+                found = true;
+                return;
             }
         }
-    }
+    });
 
-    // --> spatially variable cross sections
-    else
+    // if the loop ended without finding the interaction point, it is outside of the path
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the probability that a peel-off photon packet survives Russian roulette at the cutoff optical depth
+    constexpr double peelOffSurvivalProbability = 0.1;
+
+    // This class holds the geometric details of the path most recently walked by the current thread for a
+    // peel-off photon packet, so that the path can be reused by subsequent peel-off photon packets that have
+    // the same starting position and direction but a different wavelength.
+    class PeelOffPath
     {
-        while (generator->next())
+    public:
+        vector<int> mv;      // the cell index for each recorded segment
+        vector<double> dsv;  // the length of each recorded segment
+
+    private:
+        const SpatialGrid* _grid{nullptr};
+        Position _bfr;
+        Direction _bfk;
+        double _reach{0.};       // the cumulative distance at the end of the last recorded segment
+        bool _exhausted{false};  // true if the recorded segments cover the complete path
+
+    public:
+        // returns true if the recorded segments cover the specified path up to the specified distance
+        bool covers(const SpatialGrid* grid, const SpatialGridPath* path, double distance) const
         {
-            // remember the cumulative optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tauSca0 = tauSca;
-            double tauAbs0 = tauAbs;
-            double s0 = s;
+            Position bfr = path->position();
+            Direction bfk = path->direction();
+            return grid == _grid && bfr.x() == _bfr.x() && bfr.y() == _bfr.y() && bfr.z() == _bfr.z()
+                   && bfk.x() == _bfk.x() && bfk.y() == _bfk.y() && bfk.z() == _bfk.z()
+                   && (_exhausted || _reach > distance);
+        }
 
-            // calculate the cumulative optical depth and distance at the end of this segment
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0)
-            {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
-                tauSca += opacitySca(lambda, m, pp) * ds;
-                tauAbs += opacityAbs(lambda, m, pp) * ds;
-            }
-            s += ds;
+        // clears the recorded segments and remembers the starting position and direction of the specified path
+        void start(const SpatialGrid* grid, const SpatialGridPath* path)
+        {
+            _grid = grid;
+            _bfr = path->position();
+            _bfk = path->direction();
+            _reach = 0.;
+            _exhausted = false;
+            mv.clear();
+            dsv.clear();
+        }
 
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauinteract < tauSca)
-            {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauinteract, tauSca0, tauSca, s0, s),
-                                        NR::interpolateLinLin(tauinteract, tauSca0, tauSca, tauAbs0, tauAbs));
-                return true;
-            }
+        // records the next segment
+        void add(int m, double ds)
+        {
+            mv.push_back(m);
+            dsv.push_back(ds);
+            _reach += ds;
         }
-    }
 
-    // the interaction point is outside of the path
-    return false;
+        // indicates that the recorded segments cover the complete path
+        void finish() { _exhausted = true; }
+    };
+
+    // returns a reference to the thread-local peel-off path record
+    PeelOffPath& getPeelOffPath()
+    {
+        thread_local PeelOffPath t_path;
+        return t_path;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1194,65 +1336,74 @@ double MediumSystem::getExtinctionOpticalDepth(const PhotonPacket* pp, double di
     // if extinction is always positive, determine the optical depth at which the packet's contribution becomes zero
     double taumax = _config->hasNegativeExtinction() ? std::numeric_limits<double>::infinity() : std::log(L) + 745;
 
+    // if requested, determine the optical depth at which the packet is subjected to Russian roulette
+    double taucut = _config->peelOffCutoffOpticalDepth() > 0. ? _config->peelOffCutoffOpticalDepth()
+                                                              : std::numeric_limits<double>::infinity();
+
+    // the optical depth correction compensating for the increased weight of a packet surviving Russian roulette
+    double tauoffset = 0.;
+
     // determine the geometric details of the path and calculate the optical depth at the same time
-    auto generator = getPathSegmentGenerator(_grid, pp);
     double tau = 0.;
-    double s = 0.;
-
-    // single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
-    {
-        double section = mix(0, 0)->sectionExt(pp->wavelength());
-        while (generator->next())
-        {
-            if (generator->m() >= 0)
-            {
-                tau += section * _state.numberDensity(generator->m(), 0) * generator->ds();
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
-            }
-            s += generator->ds();
-            if (s > distance) break;
-        }
-    }
+    withOpacityKernel(pp, false, [this, pp, distance, taumax, &taucut, &tauoffset, &tau](auto& kernel) {
+        double s = 0.;
 
-    // multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
-    {
-        ShortArray sectionv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
-        while (generator->next())
-        {
-            double ds = generator->ds();
-            int m = generator->m();
+        // process the next path segment and return false if the path walk can be terminated
+        auto step = [this, distance, taumax, &taucut, &tauoffset, &tau, &kernel, &s](int m, double ds) {
             if (m >= 0)
             {
-                for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * _state.numberDensity(m, h) * ds;
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                tau += kernel.opacityExt(m, s) * ds;
+                if (tau >= taucut)
+                {
+                    taucut = std::numeric_limits<double>::infinity();
+                    if (_random->uniform() > peelOffSurvivalProbability)
+                    {
+                        tau = std::numeric_limits<double>::infinity();
+                        return false;
+                    }
+                    tauoffset = std::log(peelOffSurvivalProbability);
+                }
+                if (tau + tauoffset >= taumax)
+                {
+                    tau = std::numeric_limits<double>::infinity();
+                    return false;
+                }
             }
             s += ds;
-            if (s > distance) break;
-        }
-    }
+            return s <= distance;
+        };
 
-    // spatially variable cross sections
-    else
-    {
-        while (generator->next())
+        // if peel-off photon packets with different wavelengths may be sent along the same path,
+        // reuse or record the geometric details of the path
+        if (_config->hasScatteringDispersion())
         {
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0)
+            PeelOffPath& path = getPeelOffPath();
+            if (path.covers(_grid, pp, distance))
             {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
-                tau += opacityExt(lambda, m, pp) * ds;
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                size_t numSegments = path.mv.size();
+                for (size_t i = 0; i != numSegments; ++i)
+                    if (!step(path.mv[i], path.dsv[i])) return;
+            }
+            else
+            {
+                path.start(_grid, pp);
+                auto generator = getPathSegmentGenerator(_grid, pp);
+                while (generator->next())
+                {
+                    path.add(generator->m(), generator->ds());
+                    if (!step(generator->m(), generator->ds())) return;
+                }
+                path.finish();
             }
-            s += ds;
-            if (s > distance) break;
         }
-    }
-
-    return tau;
+        else
+        {
+            auto generator = getPathSegmentGenerator(_grid, pp);
+            while (generator->next())
+                if (!step(generator->m(), generator->ds())) return;
+        }
+    });
+    return tau + tauoffset;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1287,18 +1438,98 @@ void MediumSystem::clearRadiationField(bool primary)
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the number of consecutive spatial cells in a per-thread radiation field buffer block
+    const int numCellsPerBufferBlock = 64;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MediumSystem::storeRadiationField(bool primary, int m, int ell, double Lds)
 {
-    if (primary)
-        LockFree::add(_rf1(m, ell), Lds);
+    if (_hasRadiationFieldBuffers)
+    {
+        // cache the pointer to the buffer for this thread to avoid a map look-up for every call
+        thread_local ThreadLocalMember<RadiationFieldBuffer>* t_buffers{nullptr};
+        thread_local RadiationFieldBuffer* t_buffer{nullptr};
+        if (t_buffers != &_rfBuffers)
+        {
+            t_buffers = &_rfBuffers;
+            t_buffer = _rfBuffers.local();
+        }
+
+        // (re)allocate the block list if the buffer has not yet been used for a grid of this size
+        int numWavelengths = _wavelengthGrid->numBins();
+        auto& blocks = t_buffer->blocks;
+        if (t_buffer->numCells != _numCells || t_buffer->numWavelengths != numWavelengths)
+        {
+            blocks.clear();
+            blocks.resize((_numCells + numCellsPerBufferBlock - 1) / numCellsPerBufferBlock);
+            t_buffer->numCells = _numCells;
+            t_buffer->numWavelengths = numWavelengths;
+        }
+
+        // verify that the buffer does not mix primary and secondary contributions
+        int type = primary ? 1 : 0;
+        if (t_buffer->type != type)
+        {
+            if (t_buffer->type >= 0)
+                throw FATALERROR("Radiation field buffer mixes primary and secondary contributions");
+            t_buffer->type = type;
+        }
+
+        // locate the block for this cell, allocating it if needed, and add the contribution
+        auto& block = blocks[m / numCellsPerBufferBlock];
+        if (block.empty()) block.resize(numCellsPerBufferBlock * numWavelengths);
+        block[(m % numCellsPerBufferBlock) * numWavelengths + ell] += Lds;
+    }
     else
-        LockFree::add(_rf2c(m, ell), Lds);
+    {
+        if (primary)
+            LockFree::add(_rf1(m, ell), Lds);
+        else
+            LockFree::add(_rf2c(m, ell), Lds);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::flushRadiationFieldBuffers(bool primary)
+{
+    Array& rfv = primary ? _rf1.data() : _rf2c.data();
+    size_t size = rfv.size();
+    size_t blockSize = numCellsPerBufferBlock * _wavelengthGrid->numBins();
+
+    // the table is indexed on (m,ell) with ell varying fastest, so that each block maps to a contiguous range
+    for (auto buffer : _rfBuffers.all())
+    {
+        if (buffer->type < 0) continue;
+        if (buffer->type != (primary ? 1 : 0))
+            throw FATALERROR("Radiation field buffer is flushed into the wrong radiation field table");
+        buffer->type = -1;
+
+        size_t numBlocks = buffer->blocks.size();
+        for (size_t b = 0; b != numBlocks; ++b)
+        {
+            auto& block = buffer->blocks[b];
+            if (!block.empty())
+            {
+                size_t offset = b * blockSize;
+                size_t n = min(blockSize, size - offset);
+                for (size_t i = 0; i != n; ++i) rfv[offset + i] += block[i];
+                std::fill(block.begin(), block.end(), 0.);
+            }
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void MediumSystem::communicateRadiationField(bool primary)
 {
+    if (_hasRadiationFieldBuffers) flushRadiationFieldBuffers(primary);
+
     if (primary)
         ProcessManager::sumToAll(_rf1.data());
     else
@@ -1594,6 +1825,20 @@ bool MediumSystem::updateSecondaryDynamicMediumState()
 
 ////////////////////////////////////////////////////////////////////
 
+int MediumSystem::stateRevision() const
+{
+    return _state.revision();
+}
+
+////////////////////////////////////////////////////////////////////
+
+int MediumSystem::stateRevision(int m) const
+{
+    return _state.revision(m);
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MediumSystem::callWithMaterialState(std::function<double(const MaterialState*)> callback, int m, int h) const
 {
     MaterialState mst(_state, m, h);
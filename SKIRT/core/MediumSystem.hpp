@@ -21,6 +21,8 @@
 #include "SimulationItem.hpp"
 #include "SpatialGrid.hpp"
 #include "Table.hpp"
+#include "ThreadLocalMember.hpp"
+#include <functional>
 class Configuration;
 class MaterialState;
 class PhotonPacket;
@@ -361,6 +363,32 @@ private:
         photon packet (for example, its polarization state). */
     double opacityExt(double lambda, int m, const PhotonPacket* pp) const;
 
+    // opacity kernels used by the optical depth calculations; see MediumSystem.cpp
+    class SingleSectionKernel;
+    class MultipleSectionKernel;
+    class ShiftedSectionKernel;
+    class VariableSectionKernel;
+
+    /** This function constructs the opacity kernel that is most efficient for the media
+        configuration of the simulation and passes it to the specified function, which is usually
+        a generic lambda performing an optical depth calculation along the path of the specified
+        photon packet. Each kernel offers functions to obtain the extinction opacity or the
+        scattering and absorption opacities in a given cell at a given distance along the path.
+        Because the calculation is compiled separately for each kernel type, the loop over the path
+        segments contains no configuration tests.
+
+        For media with spatially constant cross sections, the kernel precalculates the cross
+        sections at the photon packet wavelength, and for multiple media it sums the products of
+        cross section and number density across media in a single loop that can be vectorized. For
+        media whose cross sections depend only on the perceived wavelength, which varies between
+        cells because of the bulk velocity or Hubble expansion, the kernel caches the wavelength
+        bin index for each medium along the path, so that the cross section tables need to be
+        searched only when the perceived wavelength moves to another bin. In all other cases, the
+        kernel delegates to the generic opacity functions. The \em scaAbs flag indicates whether
+        the caller needs the scattering and absorption opacities (true) or the extinction opacity
+        (false). */
+    template<class Function> void withOpacityKernel(const PhotonPacket* pp, bool scaAbs, Function fn) const;
+
 public:
     /** This function returns the perceived wavelength of the photon packet at the scattering
         interaction distance, taking into account the bulk velocity and Hubble expansion velocity
@@ -511,6 +539,35 @@ public:
         by definition. */
     void setScatteringAndAbsorptionOpticalDepths(PhotonPacket* pp) const;
 
+    /** This function calculates the cumulative extinction optical depth at the end of each path
+        segment along a path through the medium system defined by the initial position and
+        direction of the specified PhotonPacket object, without storing the path segments or the
+        optical depths in the photon packet. If the specified function is nonempty, it is called
+        for each path segment inside the spatial grid, in order of increasing distance, with the
+        cell index \f$m\f$, the segment length \f$\Delta s\f$, the cumulative distance \f$s\f$
+        and the cumulative extinction optical depth \f$\tau^\text{ext}\f$ at the segment exit.
+        For example, this allows storing the contribution of the photon packet to the radiation
+        field during the path walk.
+
+        This function is intended for a forced-scattering photon life cycle in which the complete
+        path is not stored (see Configuration::streamForcedScatteringPaths()). After calling this
+        function, the interaction point can be determined with the
+        setInteractionPointUsingExtinction() or setInteractionPointUsingScatteringAndAbsorption()
+        function, which walk the path again until the interaction point has been reached. This
+        trades memory traffic for some recalculation. The function removes any existing path
+        segments from the photon packet and sets its interaction point to the end of the path, so
+        that the latter is used should the subsequent walk not reach the interaction optical
+        depth because of round-off errors.
+
+        The function returns the total extinction optical depth along the path for a photon life
+        cycle without explicit absorption, and the total scattering optical depth for a photon life
+        cycle with explicit absorption. The opacity in each path segment is evaluated at the
+        cumulative distance at the start of the segment (which matters only in the presence of
+        Hubble expansion), exactly as is done by the functions that subsequently locate the
+        interaction point, so that both walks calculate the same optical depths. */
+    double streamOpticalDepths(PhotonPacket* pp,
+                               const std::function<void(int m, double ds, double s, double tauExt)>& visit) const;
+
     /** This function calculates the cumulative extinction optical depth and distance at the end of
         path segments along a path through the medium system defined by the initial position and
         direction of the specified PhotonPacket object until the specified interaction optical
@@ -585,7 +642,24 @@ public:
         function aborts the calculation and returns positive infinity when this happens.
 
         If the extinction cross section can be negative, this optimization cannot be applied
-        because the cumulative optical depth could decrease again further along the path. */
+        because the cumulative optical depth could decrease again further along the path.
+
+        If the user configured a peel-off cutoff optical depth \f$\tau_\mathrm{cut}\f$ (see
+        Configuration::peelOffCutoffOpticalDepth()), the photon packet is subjected to Russian
+        roulette as soon as the cumulative optical depth exceeds \f$\tau_\mathrm{cut}\f$. With a
+        probability of 90%, the function aborts the calculation and returns positive infinity.
+        Otherwise, it continues the calculation and returns the optical depth reduced by
+        \f$\ln 10\f$, which increases the observed weight of the surviving photon packet by a
+        factor of 10 so that the result remains unbiased.
+
+        <b>Shared path walks</b>
+
+        If scattering may change the wavelength of a photon packet (see
+        Configuration::hasScatteringDispersion()), a separate peel-off photon packet is sent to each
+        instrument for each medium component, with a different wavelength but along the same path.
+        In this case, the function records the geometric details of the path in a thread-local
+        data structure, and reuses them for subsequent calls with the same starting position and
+        direction, avoiding a repeated walk through the spatial grid. */
     double getExtinctionOpticalDepth(const PhotonPacket* pp, double distance) const;
 
     /** This function returns the extinction optical depth at the specified wavelength along a path
@@ -625,8 +699,13 @@ public:
         the temporary secondary table.
 
         The addition happens in a thread-safe way, so that this function can be called from
-        multiple parallel threads, even for the same spatial/wavelength bin. If any of the indices
-        are out of range, undefined behavior results. */
+        multiple parallel threads, even for the same spatial/wavelength bin. Depending on the
+        configured accumulation strategy (see RadiationFieldOptions), the value is either added
+        directly to the shared table using an atomic operation, or it is added to a private buffer
+        for the calling thread. In the latter case, the buffers are merged into the shared table
+        by the communicateRadiationField() function, and a given simulation segment must not mix
+        primary and secondary contributions. If any of the indices are out of range,
+        undefined behavior results. */
     void storeRadiationField(bool primary, int m, int ell, double Lds);
 
     /** This function accumulates the radiation field between multiple processes. In simulation
@@ -634,7 +713,9 @@ public:
         finishing a simulation segment (i.e. after a before set of photon packets has been
         launched) and before querying the radiation field's contents. If the \em primary flag is
         true, the primary table is synchronized; otherwise the temporary secondary table is
-        synchronized and its contents is copied into the stable secondary table. */
+        synchronized and its contents is copied into the stable secondary table. Before
+        synchronizing between processes, the function merges any per-thread radiation field
+        buffers into the appropriate table and clears them. */
     void communicateRadiationField(bool primary);
 
     /** This function returns a pair of values specifying the bolometric luminosity absorbed by
@@ -645,6 +726,11 @@ public:
     std::pair<double, double> totalDustAbsorbedLuminosity() const;
 
 private:
+    /** This function adds the contents of the per-thread radiation field buffers for all threads to
+        the primary table or to the temporary secondary table, depending on the \em primary flag,
+        and clears the buffers. The function must be called from serial code. */
+    void flushRadiationFieldBuffers(bool primary);
+
     /** This function returns the sum of the values in both the primary and the stable secondary
         radiation field tables at the specified cell and wavelength indices. If a table is not
         present, the value for that table is assumed to be zero. */
@@ -824,6 +910,17 @@ public:
         This function assumes that the radiation field has been calculated. */
     bool updateSecondaryDynamicMediumState();
 
+    /** This function returns the overall revision number of the medium state, which is incremented
+        each time the dynamic medium state is updated. It is zero if the medium state has not been
+        updated since its initialization. */
+    int stateRevision() const;
+
+    /** This function returns the revision number of the medium state in the spatial cell with
+        index \f$m\f$, i.e. the overall revision number at the time the state of the cell was last
+        changed by a dynamic medium state update, or zero if the state of the cell has not been
+        changed since its initialization. */
+    int stateRevision(int m) const;
+
     //=============== Specialty probing ===================
 
 public:
@@ -836,6 +933,7 @@ public:
 
 private:
     Configuration* _config{nullptr};
+    Random* _random{nullptr};
 
     // relevant for any simulation mode that includes a medium
     int _numCells{0};  // index m
@@ -861,6 +959,18 @@ private:
     Table<2> _rf2;   // radiation field from secondary sources (copied from _rf2c at the appropriate time)
     Table<2> _rf2c;  // radiation field currently being accumulated from secondary sources
 
+    // relevant for any simulation mode that stores the radiation field using per-thread buffers
+    // each buffer holds a lazily allocated block of rf entries (indexed on m,ell) for each group of consecutive cells
+    struct RadiationFieldBuffer
+    {
+        int numCells{0};                // the number of cells for which the block list was allocated
+        int numWavelengths{0};          // the number of wavelength bins for which the blocks are allocated
+        int type{-1};                   // 1 if holding primary contributions, 0 if secondary, -1 if empty
+        vector<vector<double>> blocks;  // indexed on block index
+    };
+    bool _hasRadiationFieldBuffers{false};
+    ThreadLocalMember<RadiationFieldBuffer> _rfBuffers;
+
     // relevant for any simulation mode that includes dust emission
     int _numDustEmissionWavelengths{0};
 };
@@ -128,6 +128,7 @@ void MonteCarloSimulation::runPrimaryEmission()
         parallel->call(
             Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, true, _config->hasRadiationField()); });
         instrumentSystem()->flush();
+        logLoadBalance(parallel);
     }
 
     // wait for all processes to finish and synchronize the radiation field
@@ -166,6 +167,7 @@ void MonteCarloSimulation::runSecondaryEmission()
         auto parallel = find<ParallelFactory>()->parallelDistributed();
         parallel->call(Npp, [this, storeRF](size_t i, size_t n) { performLifeCycle(i, n, false, true, storeRF); });
         instrumentSystem()->flush();
+        logLoadBalance(parallel);
     }
 
     // wait for all processes to finish and synchronize the radiation field if needed
@@ -298,6 +300,7 @@ void MonteCarloSimulation::runPrimaryEmissionIterations()
             initProgress(segment, Npp);
             parallel->call(Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, false, true); });
             instrumentSystem()->flush();
+            logLoadBalance(parallel);
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
@@ -363,6 +366,7 @@ void MonteCarloSimulation::runSecondaryEmissionIterations()
             initProgress(segment, Npp);
             parallel->call(Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, false, false, true); });
             instrumentSystem()->flush();
+            logLoadBalance(parallel);
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
@@ -431,6 +435,7 @@ void MonteCarloSimulation::runMergedEmissionIterations()
             initProgress(segment1, Npp1);
             parallel->call(Npp1, [this](size_t i, size_t n) { performLifeCycle(i, n, true, false, true); });
             instrumentSystem()->flush();
+            logLoadBalance(parallel);
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment1);
@@ -454,6 +459,7 @@ void MonteCarloSimulation::runMergedEmissionIterations()
             initProgress(segment2, Npp2);
             parallel->call(Npp2, [this](size_t i, size_t n) { performLifeCycle(i, n, false, false, true); });
             instrumentSystem()->flush();
+            logLoadBalance(parallel);
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment2);
@@ -493,6 +499,9 @@ void MonteCarloSimulation::initProgress(string segment, size_t numTotal)
 {
     _segment = segment;
 
+    // make sure that the photon packet histories in this segment use independent random sequences
+    random()->advanceHistorySegment();
+
     log()->info("Launching " + StringUtils::toString(static_cast<double>(numTotal)) + " " + _segment
                 + " photon packets");
     log()->infoSetElapsed(numTotal);
@@ -508,6 +517,50 @@ void MonteCarloSimulation::logProgress(size_t numDone)
 
 ////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::logLoadBalance(const Parallel* parallel)
+{
+    double idle = parallel->idleFraction();
+    if (idle >= 0.)
+        log()->info("Threads were idle for " + StringUtils::toString(100. * idle, 'f', 1) + "% of the time launching "
+                    + _segment + " photon packets");
+
+    // for multiple processes, gather the busy time and call duration of each process (collective operation)
+    if (ProcessManager::isMultiProc())
+    {
+        int numProcs = ProcessManager::size();
+        int rank = ProcessManager::rank();
+        double duration = max(0., parallel->callDuration());
+        Array stats(2 * numProcs);
+        stats[2 * rank] = (1. - max(0., idle)) * duration;
+        stats[2 * rank + 1] = duration;
+        ProcessManager::sumToAll(stats);
+
+        // determine the idle fraction of each process relative to the slowest process
+        double wall = 0.;
+        for (int r = 0; r != numProcs; ++r) wall = max(wall, stats[2 * r + 1]);
+        if (wall > 0.)
+        {
+            double sum = 0.;
+            int minRank = 0, maxRank = 0;
+            Array procIdle(numProcs);
+            for (int r = 0; r != numProcs; ++r)
+            {
+                procIdle[r] = 1. - stats[2 * r] / wall;
+                sum += procIdle[r];
+                if (procIdle[r] < procIdle[minRank]) minRank = r;
+                if (procIdle[r] > procIdle[maxRank]) maxRank = r;
+            }
+            log()->info("Processes were idle for " + StringUtils::toString(100. * sum / numProcs, 'f', 1)
+                        + "% of the time on average (minimum " + StringUtils::toString(100. * procIdle[minRank], 'f', 1)
+                        + "% for process " + std::to_string(minRank) + ", maximum "
+                        + StringUtils::toString(100. * procIdle[maxRank], 'f', 1) + "% for process "
+                        + std::to_string(maxRank) + ")");
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // maximum number of photon packets processed between two invocations of infoIfElapsed()
@@ -520,12 +573,20 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
 {
     PhotonPacket pp, ppp;
 
+    // the photon packets resulting from splitting that still need to be scattered and traced, each with the number
+    // of times it has been split; reused across calls to avoid reallocating path segment storage
+    thread_local vector<std::pair<PhotonPacket, int>> t_splitPackets;
+    auto& splitPackets = t_splitPackets;
+
     // loop over the history indices, with interruptions for progress logging
     while (numIndices)
     {
         size_t currentChunkSize = min(logProgressChunkSize, numIndices);
         for (size_t historyIndex = firstIndex; historyIndex != firstIndex + currentChunkSize; ++historyIndex)
         {
+            // establish the random sequence for this history (if so configured)
+            random()->setHistory(historyIndex);
+
             // launch a photon packet from the requested source
             if (primary)
                 sourceSystem()->launch(&pp, historyIndex);
@@ -542,26 +603,53 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                     if (_config->forceScattering())
                     {
                         double Lthreshold = pp.luminosity() / _config->minWeightReduction();
+                        double Lroulette = pp.luminosity() * _config->rouletteWeightThreshold();
                         int minScattEvents = _config->minScattEvents();
+                        int splitLevel = 0;              // the number of times the current packet has been split
+                        double Lterminate = Lthreshold;  // the termination threshold for the current packet
                         while (true)
                         {
-                            // calculate segments and optical depths for the complete path
-                            if (_config->explicitAbsorption())
-                                mediumSystem()->setScatteringAndAbsorptionOpticalDepths(&pp);
+                            // remember the position before propagation to detect entering the splitting region
+                            Position bfr = pp.position();
+
+                            // advance the packet, either walking the path without storing it
+                            // or calculating and storing segments and optical depths for the complete path
+                            if (_config->streamForcedScatteringPaths())
+                            {
+                                double taupath = streamForcedScatteringPath(&pp, store);
+                                simulateForcedPropagation(&pp, taupath);
+                            }
                             else
-                                mediumSystem()->setExtinctionOpticalDepths(&pp);
-
-                            // advance the packet
-                            if (store) storeRadiationField(&pp);
-                            simulateForcedPropagation(&pp);
-
-                            // if the packet's weight drops below the threshold, terminate it
+                            {
+                                if (_config->explicitAbsorption())
+                                    mediumSystem()->setScatteringAndAbsorptionOpticalDepths(&pp);
+                                else
+                                    mediumSystem()->setExtinctionOpticalDepths(&pp);
+                                if (store) storeRadiationField(&pp);
+                                simulateForcedPropagation(&pp, pp.totalOpticalDepth());
+                            }
+
+                            // if the packet's weight drops below the threshold or the packet does not survive
+                            // Russian roulette, terminate it and continue with the next split packet, if any;
+                            // the threshold for a split packet is lowered by the split factor for each split, so
+                            // that it is traced through as many scattering events as the packet it derives from
                             if (pp.luminosity() <= 0
-                                || (pp.luminosity() <= Lthreshold && pp.numScatt() >= minScattEvents))
-                                break;
-
-                            // process the scattering event
+                                || (pp.luminosity() <= Lterminate && pp.numScatt() >= minScattEvents)
+                                || !survivesRussianRoulette(&pp, Lroulette))
+                            {
+                                if (splitPackets.empty()) break;
+                                pp = splitPackets.back().first;
+                                splitLevel = splitPackets.back().second;
+                                splitPackets.pop_back();
+                                Lterminate = Lthreshold * pow(_config->splitFactor(), -splitLevel);
+                                mediumSystem()->simulateScattering(random(), &pp);
+                                continue;
+                            }
+
+                            // process the scattering event, splitting the packet if it enters the splitting region
                             if (peel) peelOffScattering(&pp, &ppp);
+                            if (splitPhotonPacket(&pp, splitLevel, bfr, Lroulette, splitPackets))
+                                Lterminate = Lthreshold * pow(_config->splitFactor(), -splitLevel);
                             mediumSystem()->simulateScattering(random(), &pp);
                         }
                     }
@@ -588,6 +676,9 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
         firstIndex += currentChunkSize;
         numIndices -= currentChunkSize;
     }
+
+    // revert to the regular random sequence for this thread
+    random()->unsetHistory();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -613,71 +704,99 @@ void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket*
 
 ////////////////////////////////////////////////////////////////////
 
-void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
+namespace
 {
-    // use a faster version in case there are no kinematics
-    if (_config->hasConstantPerceivedWavelength())
+    // This class stores the contributions of a photon packet to the radiation field in the cells crossed by its path.
+    // The segments must be passed in order of increasing distance along the path, and segments outside of the
+    // spatial grid must be omitted; this does not affect the result because they do not change the optical depth.
+    class RadiationFieldStorer
     {
-        int ell = _config->radiationFieldWLG()->bin(pp->wavelength());
-        if (ell >= 0)
+    public:
+        RadiationFieldStorer(const Configuration* config, MediumSystem* ms, const PhotonPacket* pp)
+            : _config(config), _ms(ms), _pp(pp), _luminosity(pp->luminosity()),
+              _hasPrimaryOrigin(pp->hasPrimaryOrigin())
         {
-            double luminosity = pp->luminosity();
-            bool hasPrimaryOrigin = pp->hasPrimaryOrigin();
+            // use a faster version in case there are no kinematics
+            _constantWavelength = config->hasConstantPerceivedWavelength();
+            if (_constantWavelength) _ell = config->radiationFieldWLG()->bin(pp->wavelength());
+        }
 
-            double lnExtBeg = 0.;  // extinction factor and its logarithm at begin of current segment
-            double extBeg = 1.;
-            for (const auto& segment : pp->segments())
+        // stores the contribution for a segment in cell m with length ds, cumulative distance s at the exit of the
+        // segment, and cumulative extinction optical depth tauExt at the exit of the segment
+        void store(int m, double ds, double s, double tauExt)
+        {
+            double lnExtEnd = -tauExt;  // extinction factor and its logarithm at end of current segment
+            double extEnd = exp(lnExtEnd);
+            if (_constantWavelength)
             {
-                double lnExtEnd = -segment.tauExt();  // extinction factor and its logarithm at end of current segment
-                double extEnd = exp(lnExtEnd);
-                int m = segment.m();
-                if (m >= 0)
+                if (_ell >= 0)
                 {
                     // use this flavor of the lnmean function to avoid recalculating the logarithm of the extinction
-                    double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
-                    double Lds = luminosity * extMean * segment.ds();
-                    mediumSystem()->storeRadiationField(hasPrimaryOrigin, m, ell, Lds);
+                    double extMean = SpecialFunctions::lnmean(extEnd, _extBeg, lnExtEnd, _lnExtBeg);
+                    double Lds = _luminosity * extMean * ds;
+                    _ms->storeRadiationField(_hasPrimaryOrigin, m, _ell, Lds);
                 }
-                lnExtBeg = lnExtEnd;
-                extBeg = extEnd;
             }
-        }
-    }
-    else
-    {
-        double lnExtBeg = 0.;  // extinction factor and its logarithm at begin of current segment
-        double extBeg = 1.;
-        for (const auto& segment : pp->segments())
-        {
-            double lnExtEnd = -segment.tauExt();  // extinction factor and its logarithm at end of current segment
-            double extEnd = exp(lnExtEnd);
-            int m = segment.m();
-            if (m >= 0)
+            else
             {
-                double lambda = pp->perceivedWavelength(mediumSystem()->bulkVelocity(m),
-                                                        _config->hubbleExpansionRate() * segment.s());
+                double lambda = _pp->perceivedWavelength(_ms->bulkVelocity(m), _config->hubbleExpansionRate() * s);
                 int ell = _config->radiationFieldWLG()->bin(lambda);
                 if (ell >= 0)
                 {
                     // use this flavor of the lnmean function to avoid recalculating the logarithm of the extinction
-                    double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
-                    double Lds = pp->perceivedLuminosity(lambda) * extMean * segment.ds();
-                    mediumSystem()->storeRadiationField(pp->hasPrimaryOrigin(), m, ell, Lds);
+                    double extMean = SpecialFunctions::lnmean(extEnd, _extBeg, lnExtEnd, _lnExtBeg);
+                    double Lds = _pp->perceivedLuminosity(lambda) * extMean * ds;
+                    _ms->storeRadiationField(_hasPrimaryOrigin, m, ell, Lds);
                 }
             }
-            lnExtBeg = lnExtEnd;
-            extBeg = extEnd;
+            _lnExtBeg = lnExtEnd;
+            _extBeg = extEnd;
         }
+
+    private:
+        const Configuration* _config;
+        MediumSystem* _ms;
+        const PhotonPacket* _pp;
+        double _luminosity;
+        bool _hasPrimaryOrigin;
+        bool _constantWavelength{false};
+        int _ell{-1};
+        double _lnExtBeg{0.};  // extinction factor and its logarithm at begin of current segment
+        double _extBeg{1.};
+    };
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
+{
+    RadiationFieldStorer storer(_config, mediumSystem(), pp);
+    double s = 0.;
+    size_t numSegments = pp->numSegments();
+    for (size_t i = 0; i != numSegments; ++i)
+    {
+        int m = pp->m(i);
+        double ds = pp->ds(i);
+        s += ds;
+        if (m >= 0) storer.store(m, ds, s, pp->tauExt(i));
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
-void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp)
+double MonteCarloSimulation::streamForcedScatteringPath(PhotonPacket* pp, bool store)
 {
-    // get the total optical depth
-    double taupath = pp->totalOpticalDepth();
+    if (!store) return mediumSystem()->streamOpticalDepths(pp, nullptr);
+
+    RadiationFieldStorer storer(_config, mediumSystem(), pp);
+    return mediumSystem()->streamOpticalDepths(
+        pp, [&storer](int m, double ds, double s, double tauExt) { storer.store(m, ds, s, tauExt); });
+}
+
+////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp, double taupath)
+{
     // if there is no extinction along the path, this photon packet cannot scatter, so terminate it right away
     if (taupath <= 0.)
     {
@@ -701,8 +820,20 @@ void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp)
         pp->applyBias(weight);
     }
 
-    // determine the physical position of the interaction point
-    pp->findInteractionPoint(tau);
+    // determine the physical position of the interaction point; if the path has not been stored,
+    // walk it again up to the interaction point (the interaction point has been set to the end of the path
+    // as a fallback in case the walk does not reach the interaction optical depth because of round-off)
+    if (_config->streamForcedScatteringPaths())
+    {
+        if (_config->explicitAbsorption())
+            mediumSystem()->setInteractionPointUsingScatteringAndAbsorption(pp, tau);
+        else
+            mediumSystem()->setInteractionPointUsingExtinction(pp, tau);
+    }
+    else
+    {
+        pp->findInteractionPoint(tau);
+    }
 
     // adjust the photon packet weight with the escape fraction and, depending on the type of photon cycle,
     // with either the scattered fraction or the cumulative absorption optical depth at the interaction point
@@ -723,6 +854,35 @@ void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp)
 
 ////////////////////////////////////////////////////////////////////
 
+bool MonteCarloSimulation::survivesRussianRoulette(PhotonPacket* pp, double Lroulette)
+{
+    if (pp->luminosity() >= Lroulette) return true;
+
+    double p = _config->rouletteSurvivalProbability();
+    if (random()->uniform() >= p) return false;
+    pp->applyBias(1. / p);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MonteCarloSimulation::splitPhotonPacket(PhotonPacket* pp, int& splitLevel, Position bfr, double Lroulette,
+                                             vector<std::pair<PhotonPacket, int>>& splitPackets)
+{
+    int n = _config->splitFactor();
+    if (n > 1 && splitLevel < _config->maxSplitLevels() && pp->luminosity() >= n * Lroulette
+        && _config->splitRegion().contains(pp->position()) && !_config->splitRegion().contains(bfr))
+    {
+        pp->applyBias(1. / n);
+        ++splitLevel;
+        for (int i = 1; i != n; ++i) splitPackets.emplace_back(*pp, splitLevel);
+        return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool MonteCarloSimulation::simulateNonForcedPropagation(PhotonPacket* pp)
 {
     // generate a random interaction optical depth
@@ -774,29 +934,35 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
     // now do the actual peel-off
     if (_config->hasScatteringDispersion())
     {
-        // if wavelengths may change, send a peel-off photon packet per medium component to each instrument
+        // if wavelengths may change, send a peel-off photon packet per medium component to each instrument;
+        // handle all medium components for a given observer before moving on to the next observer, so that
+        // the medium system can reuse the geometric details of the path to that observer
+        const auto& instruments = _instrumentSystem->instruments();
+        int numInstruments = instruments.size();
         int numMedia = wv.size();
-        for (int h = 0; h != numMedia; ++h)
+        for (int first = 0; first != numInstruments;)
         {
-            // skip media that don't scatter this photon packet
-            if (wv[h] > 0.)
+            // determine the range of consecutive instruments with the same observer
+            int last = first + 1;
+            while (last != numInstruments && instruments[last]->isSameObserverAsPreceding()) ++last;
+
+            // get the direction towards the observer and (for polarization only) its Y-axis orientation
+            Direction bfkobs = instruments[first]->bfkobs(pp->position());
+            Direction bfky = _config->hasPolarization() ? instruments[first]->bfky(pp->position()) : Direction();
+
+            for (int h = 0; h != numMedia; ++h)
             {
-                for (Instrument* instr : _instrumentSystem->instruments())
+                // skip media that don't scatter this photon packet
+                if (wv[h] > 0.)
                 {
-                    if (!instr->isSameObserverAsPreceding())
-                    {
-                        // get the direction towards the instrument and (for polarization only) its Y-axis orientation
-                        Direction bfkobs = instr->bfkobs(pp->position());
-                        Direction bfky = _config->hasPolarization() ? instr->bfky(pp->position()) : Direction();
-
-                        // calculate peel-off for the current component and launch the peel-off photon packet
-                        mediumSystem()->peelOffScattering(h, wv[h], lambda, bfkobs, bfky, pp, ppp);
-                    }
+                    // calculate peel-off for the current component and launch the peel-off photon packet
+                    mediumSystem()->peelOffScattering(h, wv[h], lambda, bfkobs, bfky, pp, ppp);
 
-                    // have the peel-off photon packet detected
-                    instr->detect(ppp);
+                    // have the peel-off photon packet detected by all instruments with this observer
+                    for (int i = first; i != last; ++i) instruments[i]->detect(ppp);
                 }
             }
+            first = last;
         }
     }
     else
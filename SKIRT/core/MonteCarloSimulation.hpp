@@ -13,6 +13,7 @@
 #include "ProbeSystem.hpp"
 #include "Simulation.hpp"
 #include "SourceSystem.hpp"
+class Parallel;
 class SecondarySourceSystem;
 
 //////////////////////////////////////////////////////////////////////
@@ -419,7 +420,8 @@ private:
     void wait(string scope);
 
     /** This function initializes the progress counter used in logprogress() for the specified
-        segment and logs the number of photon packets to be processed. */
+        segment and logs the number of photon packets to be processed. It also advances the segment
+        index used by the counter-based random generator, if enabled (see the Random class). */
     void initProgress(string segment, size_t numTotal);
 
     /** This function logs a progress message for the segment specified in the initprogress()
@@ -428,6 +430,17 @@ private:
         of photon packets processed. */
     void logProgress(size_t numDone);
 
+    /** This function logs the fraction of time that the execution threads of the specified
+        Parallel instance remained idle during its most recent call, i.e. while waiting for other
+        threads to finish their work for the segment specified in the initprogress() function.
+        Nothing is logged if the Parallel instance does not track this information.
+
+        If the simulation runs in multiple processes, the function also gathers the busy time and
+        call duration from all processes, and logs the average, minimum and maximum fraction of
+        time that a process was idle relative to the slowest process. In that case, this function
+        must be called from all processes. */
+    void logLoadBalance(const Parallel* parallel);
+
     /** This function launches the specified chunk of photon packets from primary or secondary
         sources, and it implements the complete life-cycle for each of these photon packets. This
         includes emission and multiple scattering events, and, if requested, the corresponding
@@ -469,7 +482,11 @@ private:
         to be handled. The \em primary flag is true to launch from primary sources, false for
         secondary sources. The \em peel flag indicates whether peeloff photon packets should be
         sent towards the instruments. The \em store flag indicates whether the contribution to the
-        radiation field should be stored. */
+        radiation field should be stored.
+
+        If the counter-based random generator is enabled (see the Random class), it is established
+        for each photon packet history before the packet is launched, so that the random sequence
+        consumed by the history depends only on its index and not on the executing thread. */
     void performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store);
 
     /** This function implements the peel-off of a photon packet after an emission event. This
@@ -527,19 +544,29 @@ private:
         unit of wavelength, and per unit of solid angle. */
     void storeRadiationField(const PhotonPacket* pp);
 
+    /** This function calculates and returns the total optical depth along the path of the
+        specified photon packet without storing the path in the photon packet, for use with a
+        forced-scattering photon life cycle configured to stream its paths (see
+        Configuration::streamForcedScatteringPaths()). If the \em store flag is true, the function
+        stores the contribution of the photon packet to the radiation field on the fly during the
+        path walk, as described for the storeRadiationField() function. The function returns the
+        extinction optical depth if explicit absorption is disabled and the scattering optical
+        depth if explicit absorption is enabled. */
+    double streamForcedScatteringPath(PhotonPacket* pp, bool store);
+
     /** This function determines the next scattering location of a photon packet in a photon life
-        cycle with forced scattering and simulates its propagation to that position. The function
-        assumes that both the geometric and optical depth information for the photon packet's path
-        have been set; if this is not the case, the behavior is undefined. This function proceeds
-        in a number of steps as outlined below.
+        cycle with forced scattering and simulates its propagation to that position. Unless the
+        paths are streamed (see Configuration::streamForcedScatteringPaths()), the function assumes
+        that both the geometric and optical depth information for the photon packet's path have
+        been set; if this is not the case, the behavior is undefined. This function proceeds in a
+        number of steps as outlined below.
 
         <b>Total optical depth</b>
 
-        We first determine the total optical depth \f$\tau_\text{path}\f$ of the photon packet's
-        path. Because the path has been calculated until the edge of the simulation's spatial grid,
-        \f$\tau_\text{path}\f$ is equal to the cumulative optical depth at the end of the last
-        segment in the path. If explicit absorption is disabled, this step uses the extinction
-        optical depth. If explicit absorption is enabled, it uses the scattering optical depth.
+        The total optical depth \f$\tau_\text{path}\f$ of the photon packet's path, calculated
+        until the edge of the simulation's spatial grid, is passed as an argument. If explicit
+        absorption is disabled, this is the extinction optical depth. If explicit absorption is
+        enabled, it is the scattering optical depth.
 
         <b>%Random optical depth</b>
 
@@ -566,7 +593,9 @@ private:
         we determine the physical position of the interaction point along the path. This is
         accomplished in two steps: a binary search among the path segments to determine the segment
         (or cell) "containing" the given cumulative optical depth, and subsequent linear
-        interpolation within the cell assuming exponential behavior of the extinction. Again, if
+        interpolation within the cell assuming exponential behavior of the extinction. If the path
+        has not been stored, the segments are instead recalculated one by one until the
+        interaction optical depth has been reached. Again, if
         explicit absorption is disabled, this step uses the extinction optical depth. If explicit
         absorption is enabled, it uses the scattering optical depth.
 
@@ -594,7 +623,34 @@ private:
         Finally we advance the initial position of the photon packet to the interaction point. This
         last step invalidates the photon packet's path (including geometric and optical depth
         information). The packet is now ready to be scattered into a new direction. */
-    void simulateForcedPropagation(PhotonPacket* pp);
+    void simulateForcedPropagation(PhotonPacket* pp, double taupath);
+
+    /** This function subjects the specified photon packet to Russian roulette if its luminosity is
+        below the specified threshold, which is derived from the launch luminosity of the photon
+        packet and the configured roulette weight threshold. The photon packet survives with the
+        configured survival probability \f$p\f$, in which case its weight is multiplied by
+        \f$1/p\f$ so that the result remains unbiased. The function returns false if the photon
+        packet must be terminated, and true otherwise. If the luminosity is not below the threshold,
+        the function returns true without consuming a random number. */
+    bool survivesRussianRoulette(PhotonPacket* pp, double Lroulette);
+
+    /** This function splits the specified photon packet if splitting is enabled, if the photon
+        packet's current (interaction) position is inside the splitting region while the specified
+        position before the last propagation step is not, if the photon packet has been split fewer
+        times than the configured maximum number of splitting levels, and if the weight of the
+        resulting photon packets would not drop below the specified Russian roulette threshold.
+        When splitting into \f$N\f$ photon packets, the function divides the weight of the
+        specified photon packet by \f$N\f$, increments the specified split level, adds \f$N-1\f$
+        copies of the photon packet to the specified list, each paired with the new split level,
+        and returns true. The copies must then be scattered and traced independently by the
+        caller. If the photon packet is not split, the function returns false.
+
+        Because the split level is carried along with each copy, the number of photon packets
+        originating from a single history is limited to \f$N^k\f$, where \f$k\f$ is the maximum
+        number of splitting levels, even if the photon packets repeatedly leave and re-enter the
+        splitting region. */
+    bool splitPhotonPacket(PhotonPacket* pp, int& splitLevel, Position bfr, double Lroulette,
+                           vector<std::pair<PhotonPacket, int>>& splitPackets);
 
     /** This function simulates the propagation of a photon packet to the next scattering location
         in a photon life cycle without forced scattering. It proceeds in a number of steps as
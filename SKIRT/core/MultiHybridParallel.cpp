@@ -31,8 +31,8 @@ void MultiHybridParallel::call(size_t maxIndex, std::function<void(size_t, size_
     // In the root process, the parent thread serves chunks to other processes
     if (ProcessManager::isRoot())
     {
-        // Initialize the chunk maker
-        _chunkMaker.initialize(maxIndex, numThreads(), ProcessManager::size());
+        // Initialize the chunk maker in guided mode
+        _chunkMaker.initialize(maxIndex, numThreads(), ProcessManager::size(), true);
 
         // Activate child threads
         activateThreads();
@@ -63,28 +63,27 @@ void MultiHybridParallel::call(size_t maxIndex, std::function<void(size_t, size_
     else
     {
         // Initialize the variables used to synchronize chunk requests with the child threads
-        _requests = 0;
         _ready = false;
         _done = false;
 
         // Activate child threads
         activateThreads();
 
-        // Serve chunks to the child threads upon their request
+        // Keep a chunk ready for the child threads, prefetching the next one as soon as it has been consumed
         bool success = true;
         while (success)
         {
-            // Wait for new chunk request
+            // Wait until the previously prefetched chunk has been consumed
             {
                 std::unique_lock<std::mutex> lock(_mutex);
-                while (!_requests || _ready) _conditionParent.wait(lock);
+                while (_ready) _conditionParent.wait(lock);
             }
 
             // Request a new chunk from the root process
             size_t firstIndex, numIndices;
             success = ProcessManager::requestChunk(firstIndex, numIndices);
 
-            // Serve the chunk to one of our child threads, or tell our child threads that there are no more chunks
+            // Offer the chunk to our child threads, or tell our child threads that there are no more chunks
             {
                 std::unique_lock<std::mutex> lock(_mutex);
                 _firstIndex = firstIndex;
@@ -104,7 +103,7 @@ void MultiHybridParallel::call(size_t maxIndex, std::function<void(size_t, size_
 
 ////////////////////////////////////////////////////////////////////
 
-bool MultiHybridParallel::doSomeWork()
+bool MultiHybridParallel::doSomeWork(int /*threadIndex*/)
 {
     // In the root process, we share the chunk maker with the parent thread
     if (ProcessManager::isRoot())
@@ -112,17 +111,9 @@ bool MultiHybridParallel::doSomeWork()
         return _chunkMaker.callForNext(_target);
     }
 
-    // In non-root processes, we ask the parent thread to request a chunk from the root process
+    // In non-root processes, we consume the chunk prefetched by the parent thread
     else
     {
-        // Request a new chunk
-        {
-            std::unique_lock<std::mutex> lock(_mutex);
-            if (_done) return false;  // exit if there are no more chunks
-            _requests++;
-        }
-        _conditionParent.notify_all();
-
         // Get the new chunk
         size_t firstIndex, numIndices;
         {
@@ -133,7 +124,6 @@ bool MultiHybridParallel::doSomeWork()
             firstIndex = _firstIndex;
             numIndices = _numIndices;
             _ready = false;
-            _requests--;
         }
         _conditionParent.notify_all();
 
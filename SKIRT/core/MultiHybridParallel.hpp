@@ -20,6 +20,13 @@
     in each process is not counted towards the number of threads specified by the user because the
     communication does not consume significant resources.
 
+    The root process uses a ChunkMaker in guided mode, so that the chunks handed out to threads and
+    processes become smaller as the work runs out. This reduces the time spent by processes waiting
+    for the slowest process to finish its last chunk. Furthermore, the parent thread in non-root
+    processes prefetches the next chunk from the root process as soon as the previous chunk has
+    been handed to one of the child threads. As a result, the communication latency for obtaining a
+    chunk overlaps with the work being performed by the child threads.
+
     This class uses the facilities offered by the MultiParallel base class. */
 class MultiHybridParallel : public MultiParallel
 {
@@ -48,7 +55,7 @@ public:
 
 private:
     /** The function to do the actual work, one chunk at a time. */
-    bool doSomeWork() override;
+    bool doSomeWork(int threadIndex) override;
 
     //======================== Data Members ========================
 
@@ -63,7 +70,6 @@ private:
     std::mutex _mutex;                           // the mutex to synchronize the threads
     std::condition_variable _conditionChildren;  // the wait condition used by the child threads
     std::condition_variable _conditionParent;    // the wait condition used by the parent thread
-    int _requests{0};                            // the number of outstanding chunk requests from child threads
     bool _ready{false};                          // true if firstIndex/numIndices represent a valid, unconsumed chunk
     bool _done{false};                           // true if there are no more chunks to be served
     size_t _firstIndex{0};                       // the first index of the new chunk being served
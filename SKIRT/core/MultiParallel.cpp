@@ -17,6 +17,8 @@ void MultiParallel::constructThreads(int numThreads)
     {
         std::unique_lock<std::mutex> lock(_mutex);
         _active.assign(_numThreads, true);
+        _startTime = std::chrono::steady_clock::now();
+        _finishTimes.assign(_numThreads, _startTime);
         for (int index = 0; index != _numThreads; ++index)
         {
             _threads.push_back(std::thread(&MultiParallel::run, this, index));
@@ -50,6 +52,7 @@ void MultiParallel::activateThreads()
     std::unique_lock<std::mutex> lock(_mutex);
     _active.assign(_numThreads, true);
     _exception = nullptr;
+    _startTime = std::chrono::steady_clock::now();
     _conditionChildren.notify_all();
 }
 
@@ -80,8 +83,9 @@ void MultiParallel::run(int threadIndex)
         {
             std::unique_lock<std::mutex> lock(_mutex);
 
-            // Indicate that this thread is no longer doing work
+            // Indicate that this thread is no longer doing work, and remember when this happened
             _active[threadIndex] = false;
+            _finishTimes[threadIndex] = std::chrono::steady_clock::now();
 
             // Tell the main thread when all parallel threads are inactive
             if (!threadsActive()) _conditionParent.notify_all();
@@ -102,7 +106,7 @@ void MultiParallel::run(int threadIndex)
         // Do work as long as some is available for this cycle, and handle exceptions
         try
         {
-            while (!_terminate && doSomeWork())
+            while (!_terminate && doSomeWork(threadIndex))
                 ;
         }
         catch (FatalError& error)
@@ -120,6 +124,33 @@ void MultiParallel::run(int threadIndex)
 
 ////////////////////////////////////////////////////////////////////
 
+double MultiParallel::idleFraction() const
+{
+    if (_finishTimes.empty()) return 0.;
+
+    // determine the moment at which the last thread finished
+    auto endTime = *std::max_element(_finishTimes.begin(), _finishTimes.end());
+    double total = std::chrono::duration<double>(endTime - _startTime).count() * _numThreads;
+    if (total <= 0.) return 0.;
+
+    // accumulate the time between each thread finishing and the last thread finishing
+    double idle = 0.;
+    for (auto finishTime : _finishTimes) idle += std::chrono::duration<double>(endTime - finishTime).count();
+    return idle / total;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MultiParallel::callDuration() const
+{
+    if (_finishTimes.empty()) return 0.;
+
+    auto endTime = *std::max_element(_finishTimes.begin(), _finishTimes.end());
+    return std::chrono::duration<double>(endTime - _startTime).count();
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool MultiParallel::threadsActive()
 {
     // Check for active threads
@@ -8,6 +8,7 @@
 
 #include "Parallel.hpp"
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -32,7 +33,11 @@ class FatalError;
     This class uses the standard low-level C++ multi-threading capabilities. It is designed to
     minimize the run-time overhead for handing out parallel tasks. Between invocations of the
     call() function, the parallel threads are put in wait so that they consume no CPU cycles (and
-    very little memory). */
+    very little memory).
+
+    The class also records the moment at which each child thread runs out of work during a call,
+    so that it can report the fraction of thread time spent idling while waiting for the other
+    threads to finish (see the idleFraction() function). */
 class MultiParallel : public Parallel
 {
     //============== Facilities offered by this class ==============
@@ -58,6 +63,16 @@ protected:
         thread) specified to constructThreads(). */
     int numThreads() { return _numThreads; }
 
+public:
+    /** This function returns the fraction of the available child thread time that was spent idling
+        during the most recent activation of the child threads, as described for the
+        Parallel::idleFraction() function. */
+    double idleFraction() const override;
+
+    /** This function returns the wall-clock duration of the most recent activation of the child
+        threads, as described for the Parallel::callDuration() function. */
+    double callDuration() const override;
+
 private:
     /** This function gets executed inside each of the parallel threads. */
     void run(int threadIndex);
@@ -74,8 +89,9 @@ private:
 
     /** The function to do the actual work; called from within run(). The function should perform
         some limited amount of work and then return true if more work might be available for this
-        cycle, and false if not. */
-    virtual bool doSomeWork() = 0;
+        cycle, and false if not. The argument specifies the index of the calling child thread, in
+        the range from zero to numThreads()-1. */
+    virtual bool doSomeWork(int threadIndex) = 0;
 
     //======================== Data Members ========================
 
@@ -95,6 +111,10 @@ private:
     FatalError* _exception{nullptr};      // a pointer to a heap-allocated copy of the exception thrown
                                           // ...  by a child thread or null if no exception was thrown
     std::atomic<bool> _terminate{false};  // becomes true when the child threads must exit
+
+    // timing information for the most recent activation; changes are protected by a mutex
+    std::chrono::steady_clock::time_point _startTime;  // the time at which the threads were activated
+    std::vector<std::chrono::steady_clock::time_point> _finishTimes;  // the time at which each thread ran out of work
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -36,7 +36,7 @@ void MultiThreadParallel::call(size_t maxIndex, std::function<void(size_t, size_
 
 ////////////////////////////////////////////////////////////////////
 
-bool MultiThreadParallel::doSomeWork()
+bool MultiThreadParallel::doSomeWork(int /*threadIndex*/)
 {
     return _chunkMaker.callForNext(_target);
 }
@@ -37,7 +37,7 @@ public:
 
 protected:
     /** The function to do the actual work, one chunk at a time. */
-    bool doSomeWork() override;
+    bool doSomeWork(int threadIndex) override;
 
     //======================== Data Members ========================
 
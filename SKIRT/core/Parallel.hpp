@@ -69,6 +69,22 @@ public:
          the available parallel resources, while still maximally reducing the overhead of handing
          out the chunks. */
     virtual void call(size_t maxIndex, std::function<void(size_t firstIndex, size_t numIndices)> target) = 0;
+
+    /** This function returns the fraction of the available thread time in the current process
+        that was spent idling during the most recent invocation of the call() function, i.e. the
+        time between the moment a thread ran out of work and the moment the last thread finished,
+        summed over all threads and divided by the number of threads times the duration of the
+        call. The default implementation returns a negative value, indicating that this
+        information is not tracked by the parallelization scheme (e.g., because it uses just a
+        single thread). */
+    virtual double idleFraction() const { return -1.; }
+
+    /** This function returns the wall-clock duration, in seconds, of the most recent invocation of
+        the call() function in the current process, measured from the moment the threads were
+        activated until the last thread ran out of work. The default implementation returns a
+        negative value, indicating that this information is not tracked by the parallelization
+        scheme. */
+    virtual double callDuration() const { return -1.; }
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -10,6 +10,7 @@
 #include "NullParallel.hpp"
 #include "ProcessManager.hpp"
 #include "SerialParallel.hpp"
+#include "WorkStealingParallel.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -42,6 +43,20 @@ int ParallelFactory::maxThreadCount() const
 
 ////////////////////////////////////////////////////////////////////
 
+void ParallelFactory::setWorkStealing(bool value)
+{
+    _workStealing = value;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool ParallelFactory::workStealing() const
+{
+    return _workStealing;
+}
+
+////////////////////////////////////////////////////////////////////
+
 int ParallelFactory::defaultThreadCount()
 {
     int count = std::thread::hardware_concurrency();
@@ -63,7 +78,9 @@ Parallel* ParallelFactory::parallel(TaskMode mode, int maxThreadCount)
     int numThreads = maxThreadCount > 0 ? std::min(maxThreadCount, _maxThreadCount) : _maxThreadCount;
 
     // Determine the Parallel subclass type (see class documentation for details)
-    ParallelType type = numThreads == 1 ? ParallelType::Serial : ParallelType::MultiThread;
+    ParallelType type = numThreads == 1 ? ParallelType::Serial
+                        : _workStealing  ? ParallelType::WorkStealing
+                                         : ParallelType::MultiThread;
     if (ProcessManager::isMultiProc())
     {
         if (mode == TaskMode::Distributed)
@@ -82,6 +99,7 @@ Parallel* ParallelFactory::parallel(TaskMode mode, int maxThreadCount)
             case ParallelType::Null: child.reset(new NullParallel(numThreads)); break;
             case ParallelType::Serial: child.reset(new SerialParallel(numThreads)); break;
             case ParallelType::MultiThread: child.reset(new MultiThreadParallel(numThreads)); break;
+            case ParallelType::WorkStealing: child.reset(new WorkStealingParallel(numThreads)); break;
             case ParallelType::MultiHybrid: child.reset(new MultiHybridParallel(numThreads)); break;
         }
     }
@@ -37,6 +37,7 @@ class Parallel;
     ----------|------------
     Distributed | All threads in all processes perform the tasks in parallel
     RootOnly | All threads in the root process perform the tasks in parallel; the other processes ignore the tasks
+    Local | All threads in the calling process perform the tasks in parallel, independently of any other processes
 
     In support of these task modes, the Parallel class has several subclasses, each implementing
     a specific parallelization scheme as described in the table below.
@@ -45,6 +46,7 @@ class Parallel;
     ----------|-----------------|------------
     S | SerialParallel | Single thread in the current process; isolated from any other processes
     MT | MultiThreadParallel | Multiple coordinated threads in the current process; isolated from any other processes
+    WS | WorkStealingParallel | Multiple threads in the current process with work stealing; isolated from any other processes
     MTP | MultiHybridParallel | One or more threads in each of multiple processes, all coordinated as a group
     0 | NullParallel | No operation; any requests for performing tasks are ignored
 
@@ -56,6 +58,11 @@ class Parallel;
     -------------|-------|-------|-------|-------|
     Distributed  |  S    |  MT   |  MTP  |  MTP  |
     RootOnly     |  S    |  MT   |  S/0  |  MT/0 |
+    Local        |  S    |  MT   |  S    |  MT   |
+
+    If work stealing has been enabled by calling the setWorkStealing() function, the factory hands
+    out a WorkStealingParallel instance (WS) instead of a MultiThreadParallel instance (MT) in the
+    table above. Work stealing is disabled by default.
 
 */
 class ParallelFactory : public SimulationItem
@@ -88,6 +95,16 @@ public:
         this factory object. */
     int maxThreadCount() const;
 
+    /** Enables or disables work-stealing scheduling for the multi-threaded Parallel objects
+        manufactured by this factory object. If enabled, the factory hands out WorkStealingParallel
+        instances rather than MultiThreadParallel instances. The value should not be changed after
+        any children have been requested. */
+    void setWorkStealing(bool value);
+
+    /** Returns true if work-stealing scheduling has been enabled for this factory object, false
+        otherwise. */
+    bool workStealing() const;
+
     /** Returns the number of logical cores detected on the computer running the code, with a
         minimum of one and a maximum of 24 (additional threads in single process do not increase
         performance). */
@@ -95,7 +112,7 @@ public:
 
     /** This enumeration includes a constant for each task allocation mode supported by ParallelFactory
      * and the Parallel subclasses. */
-    enum class TaskMode { Distributed, RootOnly };
+    enum class TaskMode { Distributed, RootOnly, Local };
 
     /** This function returns a Parallel subclass instance of the appropriate type and with an
         appropriate number of execution threads, depending on the requested task allocation mode,
@@ -114,17 +131,23 @@ public:
     /** This function calls the parallel() function for the RootOnly task allocation mode. */
     Parallel* parallelRootOnly(int maxThreadCount = 0) { return parallel(TaskMode::RootOnly, maxThreadCount); }
 
+    /** This function calls the parallel() function for the Local task allocation mode. */
+    Parallel* parallelLocal(int maxThreadCount = 0) { return parallel(TaskMode::Local, maxThreadCount); }
+
     //======================== Data Members ========================
 
 private:
     // The maximum thread count for the factory, initialized to the default maximum number of threads
     int _maxThreadCount{defaultThreadCount()};
 
+    // True if multi-threaded children should use work stealing, initialized to false
+    bool _workStealing{false};
+
     // The thread that invoked our constructor, initialized - obviously - upon construction
     std::thread::id _parentThread{std::this_thread::get_id()};
 
     // Private enumeration of the supported Parallel subclasses
-    enum class ParallelType { Null = 0, Serial, MultiThread, MultiHybrid };
+    enum class ParallelType { Null = 0, Serial, MultiThread, WorkStealing, MultiHybrid };
 
     // The collection of our children, keyed on Parallel subclass type and number of threads; initially empty
     std::map<std::pair<ParallelType, int>, std::unique_ptr<Parallel>> _children;
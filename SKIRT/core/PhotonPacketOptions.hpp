@@ -29,6 +29,55 @@
     not support storing the radiation field, which means it cannot be used when the simulation
     includes secondary emission or dynamic state iteration.
 
+    - With or without a peel-off optical depth cutoff. When a peel-off photon packet is sent
+    towards an instrument, the extinction optical depth along its path is calculated up to the
+    edge of the spatial grid. Beyond a certain optical depth, however, the contribution of the
+    peel-off photon packet becomes negligible. If the \em peelOffCutoffOpticalDepth option is
+    nonzero, a peel-off photon packet that reaches this optical depth is subjected to Russian
+    roulette: with a probability of 90% the path walk is terminated and the peel-off photon packet
+    is discarded, and otherwise the path walk continues and the contribution of the surviving
+    peel-off photon packet is increased by a factor of 10 to compensate. The results therefore
+    remain unbiased. A value of 30 or more is recommended, because the contribution of a surviving
+    photon packet then is at most \f$10\,\mathrm{e}^{-30}\approx 10^{-12}\f$ of its original
+    value, so that the additional noise is insignificant. The option is ignored for media with
+    negative extinction cross sections. By default the cutoff is disabled.
+
+    - With stored or streamed forced-scattering paths. By default, the forced-scattering photon
+    life cycle calculates and stores the geometric details and cumulative optical depths for the
+    complete path of a photon packet at each step, and then uses this information to store the
+    radiation field (if needed) and to locate the interaction point. For spatial grids with many
+    cells along a typical path, this stored information may cause substantial memory traffic. If
+    the \em streamForcedScatteringPaths option is enabled, the path is instead walked twice
+    without storing it: a first time to calculate the total optical depth while storing the
+    radiation field on the fly, and a second time, up to the interaction point, to locate that
+    point. Depending on the simulation, this can be faster or slower than the default method.
+
+    - With or without Russian roulette. In optically thick media, a forced-scattering photon
+    packet may experience hundreds of scattering events before its weight drops below the
+    termination threshold set by the \em minWeightReduction option, each requiring a path
+    calculation and peel-off. If the \em rouletteWeightThreshold option is nonzero, a photon
+    packet with a weight below this fraction of its launch weight is subjected to Russian
+    roulette after each propagation step: it survives with the probability given by the \em
+    rouletteSurvivalProbability option, in which case its weight is divided by that probability,
+    and it is terminated otherwise. This keeps the results unbiased while spending less time on
+    low-weight photon packets. By default, Russian roulette is disabled.
+
+    - With or without photon packet splitting. If the \em splitFactor option is larger than one, a
+    forced-scattering photon packet that arrives at an interaction point inside the splitting region
+    (a box specified by the \em splitMinX etc. options) coming from outside of that region, is split
+    into the specified number of photon packets, each carrying an equal part of the original weight.
+    After the peel-off for the interaction, these photon packets are scattered and traced
+    independently. This focuses the computational effort on a region of high importance, for example
+    the funnel of an optically thick torus, without biasing the results. A photon packet is not
+    split if the resulting weight would fall below the Russian roulette threshold. The termination
+    threshold set by the \em minWeightReduction option is lowered by the split factor for the
+    resulting photon packets, so that they are traced through as many scattering events as an
+    unsplit photon packet would be. Furthermore, the photon packets resulting from a split can be
+    split again (when they leave and re-enter the splitting region) only as long as the total number
+    of splits along their history does not exceed the \em maxSplitLevels option, which limits the
+    number of photon packets originating from a single launch to \f$N^k\f$ for split factor \f$N\f$
+    and \f$k\f$ levels. By default, a photon packet is split at most once.
+
     The remaining options serve to further configure the detailed behavior of the forced scattering
     photon cycle. */
 class PhotonPacketOptions : public SimulationItem
@@ -66,6 +115,83 @@ class PhotonPacketOptions : public SimulationItem
         ATTRIBUTE_RELEVANT_IF(pathLengthBias, "(ForceScattering)&(!Lya)")
         ATTRIBUTE_DISPLAYED_IF(pathLengthBias, "Level3")
 
+        PROPERTY_DOUBLE(rouletteWeightThreshold,
+                        "the weight fraction below which photon packets are subject to Russian roulette")
+        ATTRIBUTE_MIN_VALUE(rouletteWeightThreshold, "[0")
+        ATTRIBUTE_MAX_VALUE(rouletteWeightThreshold, "1[")
+        ATTRIBUTE_DEFAULT_VALUE(rouletteWeightThreshold, "0")
+        ATTRIBUTE_RELEVANT_IF(rouletteWeightThreshold, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(rouletteWeightThreshold, "Level3")
+
+        PROPERTY_DOUBLE(rouletteSurvivalProbability, "the probability for surviving Russian roulette")
+        ATTRIBUTE_MIN_VALUE(rouletteSurvivalProbability, "]0")
+        ATTRIBUTE_MAX_VALUE(rouletteSurvivalProbability, "1[")
+        ATTRIBUTE_DEFAULT_VALUE(rouletteSurvivalProbability, "0.1")
+        ATTRIBUTE_RELEVANT_IF(rouletteSurvivalProbability, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(rouletteSurvivalProbability, "Level3")
+
+        PROPERTY_INT(splitFactor, "the number of photon packets resulting from splitting in the splitting region")
+        ATTRIBUTE_MIN_VALUE(splitFactor, "1")
+        ATTRIBUTE_MAX_VALUE(splitFactor, "100")
+        ATTRIBUTE_DEFAULT_VALUE(splitFactor, "1")
+        ATTRIBUTE_RELEVANT_IF(splitFactor, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitFactor, "Level3")
+
+        PROPERTY_INT(maxSplitLevels, "the maximum number of times a photon packet history can be split")
+        ATTRIBUTE_MIN_VALUE(maxSplitLevels, "1")
+        ATTRIBUTE_MAX_VALUE(maxSplitLevels, "10")
+        ATTRIBUTE_DEFAULT_VALUE(maxSplitLevels, "1")
+        ATTRIBUTE_RELEVANT_IF(maxSplitLevels, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(maxSplitLevels, "Level3")
+
+        PROPERTY_DOUBLE(splitMinX, "the start point of the splitting region in the X direction")
+        ATTRIBUTE_QUANTITY(splitMinX, "length")
+        ATTRIBUTE_DEFAULT_VALUE(splitMinX, "0")
+        ATTRIBUTE_RELEVANT_IF(splitMinX, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitMinX, "Level3")
+
+        PROPERTY_DOUBLE(splitMaxX, "the end point of the splitting region in the X direction")
+        ATTRIBUTE_QUANTITY(splitMaxX, "length")
+        ATTRIBUTE_DEFAULT_VALUE(splitMaxX, "0")
+        ATTRIBUTE_RELEVANT_IF(splitMaxX, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitMaxX, "Level3")
+
+        PROPERTY_DOUBLE(splitMinY, "the start point of the splitting region in the Y direction")
+        ATTRIBUTE_QUANTITY(splitMinY, "length")
+        ATTRIBUTE_DEFAULT_VALUE(splitMinY, "0")
+        ATTRIBUTE_RELEVANT_IF(splitMinY, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitMinY, "Level3")
+
+        PROPERTY_DOUBLE(splitMaxY, "the end point of the splitting region in the Y direction")
+        ATTRIBUTE_QUANTITY(splitMaxY, "length")
+        ATTRIBUTE_DEFAULT_VALUE(splitMaxY, "0")
+        ATTRIBUTE_RELEVANT_IF(splitMaxY, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitMaxY, "Level3")
+
+        PROPERTY_DOUBLE(splitMinZ, "the start point of the splitting region in the Z direction")
+        ATTRIBUTE_QUANTITY(splitMinZ, "length")
+        ATTRIBUTE_DEFAULT_VALUE(splitMinZ, "0")
+        ATTRIBUTE_RELEVANT_IF(splitMinZ, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitMinZ, "Level3")
+
+        PROPERTY_DOUBLE(splitMaxZ, "the end point of the splitting region in the Z direction")
+        ATTRIBUTE_QUANTITY(splitMaxZ, "length")
+        ATTRIBUTE_DEFAULT_VALUE(splitMaxZ, "0")
+        ATTRIBUTE_RELEVANT_IF(splitMaxZ, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(splitMaxZ, "Level3")
+
+        PROPERTY_BOOL(streamForcedScatteringPaths, "walk forced-scattering paths twice rather than storing them")
+        ATTRIBUTE_DEFAULT_VALUE(streamForcedScatteringPaths, "false")
+        ATTRIBUTE_RELEVANT_IF(streamForcedScatteringPaths, "ForceScattering")
+        ATTRIBUTE_DISPLAYED_IF(streamForcedScatteringPaths, "Level3")
+
+        PROPERTY_DOUBLE(peelOffCutoffOpticalDepth,
+                        "the optical depth beyond which peel-off photon packets are subject to Russian roulette")
+        ATTRIBUTE_MIN_VALUE(peelOffCutoffOpticalDepth, "[0")
+        ATTRIBUTE_MAX_VALUE(peelOffCutoffOpticalDepth, "1000]")
+        ATTRIBUTE_DEFAULT_VALUE(peelOffCutoffOpticalDepth, "0")
+        ATTRIBUTE_DISPLAYED_IF(peelOffCutoffOpticalDepth, "Level3")
+
     ITEM_END()
 };
 
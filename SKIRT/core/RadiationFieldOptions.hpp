@@ -15,9 +15,26 @@
     related to the radiation field. A simulation always stores the radiation field when it has a
     secondary emission phase or when it has a dynamic medium state (or both). If neither is the
     case, and forced scattering is enabled (see PhotonPacketOptions), the user can still request to
-    store the radiation field so that it can be probed for output. */
+    store the radiation field so that it can be probed for output.
+
+    The \em accumulationStrategy option determines how the contributions of the photon packets to
+    the radiation field are accumulated when the simulation runs in multiple threads. With the \em
+    Atomic strategy, each contribution is added directly to the shared radiation field table using
+    an atomic compare-and-swap operation. With the \em PerThread strategy, each thread accumulates
+    its contributions in a private buffer that is allocated in blocks of spatial cells as they are
+    touched. The private buffers are merged into the shared table at the end of each simulation
+    segment. This avoids cache line contention between threads at the cost of extra memory. If
+    the worst-case memory requirement for the private buffers (i.e. the size of the radiation field
+    table times the number of threads) exceeds the budget specified by the \em
+    maxAccumulationMemory option, or if the simulation runs in a single thread, the simulation
+    automatically falls back to the \em Atomic strategy. */
 class RadiationFieldOptions : public SimulationItem
 {
+    ENUM_DEF(AccumulationStrategy, Atomic, PerThread)
+        ENUM_VAL(AccumulationStrategy, Atomic, "atomically add each contribution to the shared table")
+        ENUM_VAL(AccumulationStrategy, PerThread, "accumulate in per-thread buffers merged after each segment")
+    ENUM_END()
+
     ITEM_CONCRETE(RadiationFieldOptions, SimulationItem, "a set of options related to the radiation field")
 
         PROPERTY_BOOL(storeRadiationField, "store the radiation field so that it can be probed for output")
@@ -31,6 +48,19 @@ class RadiationFieldOptions : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(radiationFieldWLG, "LogWavelengthGrid")
         ATTRIBUTE_RELEVANT_IF(radiationFieldWLG, "RadiationField&Panchromatic")
 
+        PROPERTY_ENUM(accumulationStrategy, AccumulationStrategy,
+                      "the strategy for accumulating the radiation field in multiple threads")
+        ATTRIBUTE_DEFAULT_VALUE(accumulationStrategy, "Atomic")
+        ATTRIBUTE_RELEVANT_IF(accumulationStrategy, "RadiationField")
+        ATTRIBUTE_DISPLAYED_IF(accumulationStrategy, "Level3")
+
+        PROPERTY_DOUBLE(maxAccumulationMemory, "the maximum memory for per-thread radiation field buffers (in GB)")
+        ATTRIBUTE_MIN_VALUE(maxAccumulationMemory, "[0")
+        ATTRIBUTE_MAX_VALUE(maxAccumulationMemory, "1e6]")
+        ATTRIBUTE_DEFAULT_VALUE(maxAccumulationMemory, "4")
+        ATTRIBUTE_RELEVANT_IF(maxAccumulationMemory, "RadiationField&accumulationStrategyPerThread")
+        ATTRIBUTE_DISPLAYED_IF(maxAccumulationMemory, "Level3")
+
     ITEM_END()
 };
 
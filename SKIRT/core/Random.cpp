@@ -8,6 +8,7 @@
 #include "NR.hpp"
 #include "Position.hpp"
 #include "SpecialFunctions.hpp"
+#include <cstdint>
 #include <random>
 #include <stack>
 
@@ -15,16 +16,117 @@
 
 namespace
 {
+    // converts 64 random bits to a double precision number in the open interval (0,1)
+    inline double toUniform(uint64_t bits)
+    {
+        return (static_cast<double>(bits >> 11) + 0.5) * (1. / 9007199254740992.);  // 2^53
+    }
+
+    // This helper class implements the Philox4x32-10 counter-based generator (Salmon et al. 2011).
+    // The output block is a pure function of the 64-bit key and the 128-bit counter, so that any
+    // element of the sequence can be obtained without generating the preceding elements.
+    // The generator produces a small block of deviates at a time; because the rounds for the
+    // consecutive counters in a block are independent, the compiler can interleave or vectorize them.
+    class Philox
+    {
+    private:
+        static constexpr int numBlocks = 4;                  // the number of counters processed in one refill
+        static constexpr int bufferSize = 2 * numBlocks;     // the number of deviates derived in one refill
+        uint32_t _key0{0}, _key1{0};                         // the key
+        uint64_t _history{0}, _counter{0};                   // the counter, i.e. history index and block index
+        double _buffer[bufferSize];                          // the deviates derived from the current blocks
+        int _index{bufferSize};                              // the index of the next unused deviate in the buffer
+
+        // generates the output blocks for the next counters and refills the buffer
+        void generate()
+        {
+            uint32_t c0[numBlocks], c1[numBlocks], c2[numBlocks], c3[numBlocks];
+            for (int b = 0; b != numBlocks; ++b)
+            {
+                uint64_t counter = _counter + b;
+                c0[b] = static_cast<uint32_t>(_history);
+                c1[b] = static_cast<uint32_t>(_history >> 32);
+                c2[b] = static_cast<uint32_t>(counter);
+                c3[b] = static_cast<uint32_t>(counter >> 32);
+            }
+            uint32_t k0 = _key0;
+            uint32_t k1 = _key1;
+            for (int round = 0; round != 10; ++round)
+            {
+                for (int b = 0; b != numBlocks; ++b)
+                {
+                    uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0[b];
+                    uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2[b];
+                    c0[b] = static_cast<uint32_t>(p1 >> 32) ^ c1[b] ^ k0;
+                    c1[b] = static_cast<uint32_t>(p1);
+                    c2[b] = static_cast<uint32_t>(p0 >> 32) ^ c3[b] ^ k1;
+                    c3[b] = static_cast<uint32_t>(p0);
+                }
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            for (int b = 0; b != numBlocks; ++b)
+            {
+                _buffer[2 * b] = toUniform((static_cast<uint64_t>(c0[b]) << 32) | c1[b]);
+                _buffer[2 * b + 1] = toUniform((static_cast<uint64_t>(c2[b]) << 32) | c3[b]);
+            }
+            _index = 0;
+            _counter += numBlocks;
+        }
+
+    public:
+        // establishes the key and history index, and resets the draw counter
+        void setState(int seed, int segment, size_t history)
+        {
+            _key0 = static_cast<uint32_t>(seed);
+            _key1 = static_cast<uint32_t>(segment);
+            _history = history;
+            _counter = 0;
+            _index = bufferSize;
+        }
+
+        // get uniform deviate
+        double get()
+        {
+            if (_index == bufferSize) generate();
+            return _buffer[_index++];
+        }
+    };
+
     // This helper class represents a pseudo-random generator. An instance is always constructed as
     // an arbitrary generator, but it can be turned into a predictable generator through setState().
+    // In addition, the generator can be temporarily switched to a counter-based generator for a
+    // given photon packet history through setHistory().
+    //
+    // The regular generator produces a block of uniform deviates at a time into a buffer, so that
+    // the conversion from random bits to floating point numbers can be vectorized by the compiler
+    // and the per-call overhead is limited to a buffer index comparison. The generator also holds
+    // the spare Gaussian deviate produced by the polar method so that it can be returned by the
+    // next call to gauss().
     class Rand
     {
     private:
+        static constexpr int bufferSize = 256;  // the number of uniform deviates generated in one refill
         // use 64-bit Mersenne twister
         std::mt19937_64 _generator;
-        // explicitly exclude zero from range; one is excluded automatically
-        std::uniform_real_distribution<double> _distribution{
-            std::nextafter(static_cast<double>(0.), static_cast<double>(1.)), 1.};
+        // buffer with pregenerated uniform deviates, and the index of the next unused deviate
+        double _buffer[bufferSize];
+        int _index{bufferSize};
+        // the counter-based generator, used only while a history is active
+        Philox _philox;
+        bool _hasHistory{false};
+        // the spare Gaussian deviate, if any
+        double _spareGauss{0.};
+        bool _hasSpareGauss{false};
+
+        // refills the buffer of uniform deviates
+        void generate()
+        {
+            uint64_t bits[bufferSize];
+            for (int i = 0; i != bufferSize; ++i) bits[i] = _generator();
+            for (int i = 0; i != bufferSize; ++i) _buffer[i] = toUniform(bits[i]);
+            _index = 0;
+        }
 
     public:
         // construct arbitrary generator, seeded with a truly random sequence
@@ -41,10 +143,49 @@ namespace
             std::seed_seq seedseq{979364188u + seed, 871244425u + seed, 1693909487u + seed, 1290454318u + seed,
                                   210509498u + seed, 542237529u + seed, 3429911442u + seed, 3321294726u + seed};
             _generator.seed(seedseq);
+            _index = bufferSize;
+            _hasHistory = false;
+            _hasSpareGauss = false;
+        }
+
+        // switch to the counter-based generator for the given key and history index
+        void setHistory(int seed, int segment, size_t history)
+        {
+            _philox.setState(seed, segment, history);
+            _hasHistory = true;
+            _hasSpareGauss = false;
+        }
+
+        // switch back to the regular generator
+        void unsetHistory()
+        {
+            _hasHistory = false;
+            _hasSpareGauss = false;
         }
 
         // get uniform deviate
-        double get() { return _distribution(_generator); }
+        double get()
+        {
+            if (_hasHistory) return _philox.get();
+            if (_index == bufferSize) generate();
+            return _buffer[_index++];
+        }
+
+        // get the spare Gaussian deviate, if available, and return true; otherwise return false
+        bool getSpareGauss(double& x)
+        {
+            if (!_hasSpareGauss) return false;
+            _hasSpareGauss = false;
+            x = _spareGauss;
+            return true;
+        }
+
+        // store a spare Gaussian deviate
+        void setSpareGauss(double x)
+        {
+            _spareGauss = x;
+            _hasSpareGauss = true;
+        }
     };
 
     // allocate a random generator for each thread, constructed when the thread is created
@@ -76,6 +217,11 @@ double Random::uniform()
 
 double Random::gauss()
 {
+    // return the deviate left over from the previous call, if any
+    double x;
+    if (_rng.getSpareGauss(x)) return x;
+
+    // otherwise use the polar method to produce two deviates, and keep one for the next call
     double rsq, v1, v2;
     do
     {
@@ -83,7 +229,9 @@ double Random::gauss()
         v2 = 2.0 * uniform() - 1.0;
         rsq = v1 * v1 + v2 * v2;
     } while (rsq >= 1.0 || rsq == 0.0);
-    return v2 * sqrt(-2.0 * log(rsq) / rsq);
+    double factor = sqrt(-2.0 * log(rsq) / rsq);
+    _rng.setSpareGauss(v1 * factor);
+    return v2 * factor;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -113,9 +261,16 @@ double Random::exponCutoff(double xmax)
 
 Direction Random::direction()
 {
-    double theta = acos(2.0 * uniform() - 1.0);
-    double phi = 2.0 * M_PI * uniform();
-    return Direction(theta, phi);
+    // use the rejection method by Marsaglia (1972) to avoid evaluating trigonometric functions
+    double rsq, v1, v2;
+    do
+    {
+        v1 = 2.0 * uniform() - 1.0;
+        v2 = 2.0 * uniform() - 1.0;
+        rsq = v1 * v1 + v2 * v2;
+    } while (rsq >= 1.0);
+    double factor = 2.0 * sqrt(1.0 - rsq);
+    return Direction(v1 * factor, v2 * factor, 1.0 - 2.0 * rsq);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -214,3 +369,24 @@ void Random::pop()
 }
 
 //////////////////////////////////////////////////////////////////////
+
+void Random::advanceHistorySegment()
+{
+    if (counterBasedHistories()) _segment++;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Random::setHistory(size_t historyIndex)
+{
+    if (counterBasedHistories()) _rng.setHistory(seed(), _segment, historyIndex);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Random::unsetHistory()
+{
+    if (counterBasedHistories()) _rng.unsetHistory();
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -53,7 +53,31 @@ class Vec;
     sequence is required in multiple places.
 
     All random number generators used in this class are based on the 64-bit Mersenne twister, which
-    offers a sufficiently long period and acceptable spectral properties for most purposes. */
+    offers a sufficiently long period and acceptable spectral properties for most purposes. To
+    limit the overhead per call, each thread-local generator produces a block of uniform deviates
+    at a time into a buffer, from which subsequent calls to the uniform() function are served.
+
+    <b>Counter-based photon packet histories</b>
+
+    With the default configuration, the pseudo-random sequence consumed by a particular photon
+    packet history depends on the execution thread that happens to process the history, and thus on
+    the number of threads and processes and on the way in which the history indices are chunked.
+    If the user-configurable \em counterBasedHistories flag is enabled, the random numbers consumed
+    during a photon packet history are instead obtained from a counter-based generator of the
+    Philox4x32-10 type (Salmon et al. 2011, Proceedings of SC11). The output of this generator is a
+    pure function of a key and a counter. The key is formed by the \em seed property and a segment
+    index that is advanced for each simulation segment (see the advanceHistorySegment() function).
+    The counter is formed by the history index and the number of deviates already drawn for that
+    history. As a result, each photon packet history receives exactly the same pseudo-random
+    sequence regardless of the thread or process that performs it. Apart from round-off
+    differences caused by the order in which contributions are accumulated, simulation results
+    are then reproducible across thread and process counts.
+
+    The history-specific generator is activated for the current thread by calling the
+    setHistory() function before the history is started, and it is deactivated by calling the
+    unsetHistory() function after the last history in a chunk has been completed. Outside of
+    photon packet histories, or if the \em counterBasedHistories flag is disabled, the regular
+    generators described above are used. */
 class Random : public SimulationItem
 {
     ITEM_CONCRETE(Random, SimulationItem, "the default random generator")
@@ -64,6 +88,11 @@ class Random : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(seed, "0")
         ATTRIBUTE_DISPLAYED_IF(seed, "Level3")
 
+        PROPERTY_BOOL(counterBasedHistories,
+                      "use a counter-based generator so that photon packet histories are reproducible")
+        ATTRIBUTE_DEFAULT_VALUE(counterBasedHistories, "false")
+        ATTRIBUTE_DISPLAYED_IF(counterBasedHistories, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
@@ -84,7 +113,9 @@ public:
     /** This function generates a random number from a Gaussian distribution function with mean 0
         and standard deviation 1, i.e. defined by the probability distribution \f[ p(x)\,{\rm d}x =
         \frac{1}{\sqrt{2\pi}}\, {\rm e}^{-\frac12\,x^2}\,{\rm d}x.\f] The algorithm used and the
-        implementation are taken from Press et al. (2002). */
+        implementation are taken from Press et al. (2002). The polar method employed by this
+        algorithm produces two independent deviates at a time; the second deviate is remembered
+        for the current thread and returned by the next call to this function. */
     double gauss();
 
     /** This function generates a random number from an exponential distribution function, defined
@@ -101,14 +132,13 @@ public:
     /** This function generates a random direction on the unit sphere, i.e. a couple
         \f$(\theta,\phi)\f$ from the two-dimensional probability density \f[
         p(\theta,\phi)\,d\theta\,d\phi = \left(\frac{\sin\theta}{2}\,d\theta\right)
-        \left(\frac{1}{2\pi}\,d\varphi\right).\f] A random direction on the unit sphere can thus be
-        constructed by taking two uniform deviates \f${\cal{X}}_1\f$ and \f${\cal{X}}_2\f$, and
-        solving the two equations \f[ \begin{split} {\cal{X}}_1 &= \int_0^\theta
-        \frac{\sin\theta'\,d\theta'}{2} \\ {\cal{X}}_2 &= \int_0^\varphi \frac{d\varphi'}{2\pi}
-        \end{split} \f] for \f$\theta\f$ and \f$\varphi\f$. The solution is readily found, \f[
-        \begin{split} \theta &= \arccos\left(2{\cal{X}}_1-1\right) \\ \varphi &= 2\pi\,{\cal {X}}_2.
-        \end{split} \f] Once these spherical coordinates are calculated, a Direction object can be
-        constructed by calling the constructor Direction::Direction(double theta, double phi). */
+        \left(\frac{1}{2\pi}\,d\varphi\right).\f] To avoid evaluating inverse and regular
+        trigonometric functions, the function uses the rejection method by Marsaglia (1972, Ann.
+        Math. Stat. 43, 645). Two uniform deviates \f$v_1\f$ and \f$v_2\f$ are drawn from the
+        interval \f$(-1,1)\f$ until \f$s=v_1^2+v_2^2<1\f$. The Cartesian components of the random
+        direction are then given by \f[ k_x = 2v_1\sqrt{1-s}, \quad k_y = 2v_2\sqrt{1-s}, \quad k_z
+        = 1-2s. \f] On average, this requires \f$8/\pi\approx2.55\f$ uniform deviates per
+        direction. */
     Direction direction();
 
     /** This function generates a new direction on the unit sphere deviating from a given original
@@ -175,6 +205,34 @@ public:
         thread. If the stack does not contain a random number generator, the behavior of this
         function is undefined. */
     void pop();
+
+    //=================== Counter-based photon packet histories ===================
+
+public:
+    /** This function advances the segment index that forms part of the key for the counter-based
+        generator, so that subsequent photon packet histories receive pseudo-random sequences that
+        are independent of those used during previous simulation segments, even if the history
+        indices are the same. The function must be called from the parent thread in each process,
+        at the same point in the execution flow, before the photon packet histories for a new
+        segment are launched. If the \em counterBasedHistories flag is disabled, this function does
+        nothing. */
+    void advanceHistorySegment();
+
+    /** If the \em counterBasedHistories flag is enabled, this function establishes the
+        counter-based generator for the specified photon packet history index and the current
+        segment as the active random number generator for the current thread, and resets the draw
+        counter to zero. If the flag is disabled, this function does nothing. */
+    void setHistory(size_t historyIndex);
+
+    /** This function re-establishes the regular random number generator for the current thread
+        after a call to setHistory(). If the \em counterBasedHistories flag is disabled, or if
+        setHistory() was not called, this function does nothing. */
+    void unsetHistory();
+
+    //======================== Data Members ========================
+
+private:
+    int _segment{0};  // the current segment index forming part of the counter-based generator key
 };
 
 //////////////////////////////////////////////////////////////////////
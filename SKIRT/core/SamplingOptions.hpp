@@ -34,7 +34,16 @@
 
     Similarly, the medium system maintains at most a single magnetic field vector per spatial cell.
     However, because the configuration can contain at most one medium component that specifies a
-    magnetic field, there is no need for aggregation over multiple components. */
+    magnetic field, there is no need for aggregation over multiple components.
+
+    Finally, if the \em cacheSpatialGrid flag is turned on, the structure of the spatial grid
+    (including, for example, the neighbor lists and the search data structures of tree grids and
+    Voronoi tessellations) is stored in a binary cache file in the input directory after it has
+    been constructed. Subsequent simulations with the same spatial grid configuration and input
+    data load the grid structure from this file rather than rebuilding it. Because constructing a
+    tree grid consumes random numbers, a simulation that loads the grid from the cache uses a
+    different random sequence than one that constructs it; the results are statistically
+    equivalent but not identical. Refer to the GridCache class for more information. */
 class SamplingOptions : public SimulationItem
 {
     /** The enumeration type defining a policy for aggregating (in each spatial cell) a single bulk
@@ -64,6 +73,10 @@ class SamplingOptions : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(aggregateVelocity, "Average")
         ATTRIBUTE_RELEVANT_IF(aggregateVelocity, "MediumVelocity")
 
+        PROPERTY_BOOL(cacheSpatialGrid, "cache the constructed spatial grid on disk for reuse by later simulations")
+        ATTRIBUTE_DEFAULT_VALUE(cacheSpatialGrid, "false")
+        ATTRIBUTE_DISPLAYED_IF(cacheSpatialGrid, "Level3")
+
     ITEM_END()
 };
 
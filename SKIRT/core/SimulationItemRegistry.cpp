@@ -232,6 +232,7 @@
 #include "SpatialGridPlotProbe.hpp"
 #include "SpatialGridSourceDensityProbe.hpp"
 #include "SpecificLuminosityNormalization.hpp"
+#include "SpectralClusterCellLibrary.hpp"
 #include "SpheExpRedistributeGeometryDecorator.hpp"
 #include "Sphere1DSpatialGrid.hpp"
 #include "Sphere2DSpatialGrid.hpp"
@@ -623,6 +624,7 @@ SimulationItemRegistry::SimulationItemRegistry(string version, string format)
     ItemRegistry::add<AllCellsLibrary>();
     ItemRegistry::add<FieldStrengthCellLibrary>();
     ItemRegistry::add<TemperatureWavelengthCellLibrary>();
+    ItemRegistry::add<SpectralClusterCellLibrary>();
 
     // dynamic medium state recipes
     ItemRegistry::add<DynamicStateRecipe>();
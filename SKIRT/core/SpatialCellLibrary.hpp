@@ -48,12 +48,14 @@ public:
         indicates that the cell is not included in the mapping and should not be used (for example,
         because the cell will produce a negligible amount of emission or no emission at all).
 
-        The argument array \em bv with length \f$N_\text{cells}\f$ provides a value passed from the
-        caller for each cell in the spatial grid. If the value is zero, the cell will not be used
-        by the caller regardless of the returned mapping index, and thus it can safely be omitted
-        from the mapping (i.e. given an index of -1). If the \em bv value for the cell is nonzero,
-        the caller plans to use the cell, but it will still refrain from doing so if the library
-        decides not to map the cell (i.e. give it an index of -1).
+        The argument array \em bv with length \f$N_\text{cells}\f$ provides the (bolometric)
+        luminosity that the caller expects each cell in the spatial grid to emit. If the value is
+        zero, the cell will not be used by the caller regardless of the returned mapping index, and
+        thus it can safely be omitted from the mapping (i.e. given an index of -1). If the \em bv
+        value for the cell is nonzero, the caller plans to use the cell, but it will still refrain
+        from doing so if the library decides not to map the cell (i.e. give it an index of -1).
+        Most libraries use these values only to decide which cells to map; a library may also use
+        them to give more weight to the cells that dominate the emission.
 
         This function must be implemented by each subclass. */
     virtual vector<int> mapping(const Array& bv) const = 0;
@@ -0,0 +1,224 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SpectralClusterCellLibrary.hpp"
+#include "Configuration.hpp"
+#include "Log.hpp"
+#include "MediumSystem.hpp"
+#include "NR.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "Random.hpp"
+#include "StringUtils.hpp"
+#include "Table.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+int SpectralClusterCellLibrary::numEntries() const
+{
+    return _numClusters;
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the local radiation field in the Milky Way (Mathis et al. 1983) integrated over all wavelengths
+    const double JtotMW = 1.7623e-06;
+
+    // the smallest field strength for cells to be included in the mapping
+    const double Umin = 1e-6;
+
+    // the seed for the random generator used to select cells
+    const int clusterSeed = 47;
+
+    // the fraction of cells selected uniformly rather than in proportion to their luminosity
+    const double uniformFraction = 0.5;
+
+    // stores the feature vector for the radiation field in the given cell into the specified memory location,
+    // which must have room for the number of radiation field wavelength bins plus one
+    void storeFeatures(double* xv, int m, const MediumSystem* ms, const Array& dlambdav)
+    {
+        Array ev = ms->meanIntensity(m) * dlambdav;
+        double Jtot = ev.sum();
+        int numWavelengths = ev.size();
+        xv[0] = log10(Jtot / JtotMW);
+        for (int ell = 0; ell != numWavelengths; ++ell) xv[ell + 1] = sqrt(ev[ell] / Jtot);
+    }
+
+    // returns the index of the cluster center nearest to the given feature vector and stores the corresponding
+    // squared distance in the last argument; the summation for a center is abandoned as soon as the partial
+    // distance exceeds the smallest distance found so far, in chunks of features to limit the number of tests
+    int nearestCenter(const double* xv, const Table<2>& centers, int numClusters, int numFeatures, double& distance)
+    {
+        const int chunkSize = 8;
+        int nearest = 0;
+        distance = DBL_MAX;
+        for (int c = 0; c != numClusters; ++c)
+        {
+            const double* cv = &centers.data()[centers.flattenedIndex(c, 0)];
+            double d = 0.;
+            for (int first = 0; first < numFeatures && d < distance; first += chunkSize)
+            {
+                int last = min(first + chunkSize, numFeatures);
+                for (int i = first; i != last; ++i)
+                {
+                    double diff = xv[i] - cv[i];
+                    d += diff * diff;
+                }
+            }
+            if (d < distance)
+            {
+                distance = d;
+                nearest = c;
+            }
+        }
+        return nearest;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<int> SpectralClusterCellLibrary::mapping(const Array& bv) const
+{
+    // get the radiation field wavelength grid and the medium system
+    const Array& dlambdav = find<Configuration>()->radiationFieldWLG()->dlambdav();
+    auto ms = find<MediumSystem>();
+    auto log = find<Log>();
+    auto parallel = find<ParallelFactory>()->parallelLocal();
+    int numCells = ms->numCells();
+    int numFeatures = dlambdav.size() + 1;
+
+    // make a list of the cells that will be used by the caller and that have a meaningful radiation field
+    vector<int> mv;
+    for (int m = 0; m != numCells; ++m)
+    {
+        if (bv[m] && (ms->meanIntensity(m) * dlambdav).sum() / JtotMW > Umin) mv.push_back(m);
+    }
+    int numUsed = mv.size();
+
+    // if there are no more cells than library entries, simply give each cell its own entry
+    vector<int> nv(numCells, -1);
+    if (numUsed <= _numClusters)
+    {
+        for (int i = 0; i != numUsed; ++i) nv[mv[i]] = i;
+        log->info("  Mapping each of " + std::to_string(numUsed) + " cells to its own library entry");
+        return nv;
+    }
+
+    // construct the cumulative distribution for selecting cells, composed of a uniform distribution and a
+    // distribution proportional to the luminosity, so that the clusters resolve the cells that dominate the
+    // emission while still covering the other cells
+    double Ltot = 0.;
+    for (int m : mv) Ltot += bv[m];
+    Array Xv;
+    NR::cdf(Xv, numUsed,
+            [&](int i) { return uniformFraction / numUsed + (1. - uniformFraction) * bv[mv[i]] / Ltot; });
+
+    // use a predictable random sequence so that all processes construct the same mapping
+    auto random = find<Random>();
+    random->push(clusterSeed);
+
+    // initialize the cluster centers to the feature vectors of randomly selected distinct cells
+    Table<2> centers(_numClusters, numFeatures);
+    {
+        vector<bool> selected(numUsed);
+        for (int c = 0; c != _numClusters; ++c)
+        {
+            int i = NR::locateClip(Xv, random->uniform());
+            while (selected[i]) i = NR::locateClip(Xv, random->uniform());
+            selected[i] = true;
+            storeFeatures(&centers(c, 0), mv[i], ms, dlambdav);
+        }
+    }
+
+    // refine the cluster centers using mini-batch k-means iterations
+    log->info("  Clustering " + std::to_string(numUsed) + " cells into " + std::to_string(_numClusters)
+              + " library entries using " + std::to_string(_numIterations) + " iterations");
+    vector<int> countv(_numClusters);  // number of cells assigned to each center so far
+    vector<int> batchv(_batchSize);    // indices in mv of the cells in the current batch
+    vector<int> nearestv(_batchSize);  // index of the nearest center for each cell in the current batch
+    Table<2> features(_batchSize, numFeatures);
+    for (int iteration = 0; iteration != _numIterations; ++iteration)
+    {
+        // draw a random sample of cells
+        for (int b = 0; b != _batchSize; ++b) batchv[b] = NR::locateClip(Xv, random->uniform());
+
+        // calculate the feature vectors and the nearest center for these cells in parallel
+        parallel->call(_batchSize, [&](size_t firstIndex, size_t numIndices) {
+            for (size_t b = firstIndex; b != firstIndex + numIndices; ++b)
+            {
+                double* xv = &features(b, 0);
+                storeFeatures(xv, mv[batchv[b]], ms, dlambdav);
+                double distance;
+                nearestv[b] = nearestCenter(xv, centers, _numClusters, numFeatures, distance);
+            }
+        });
+
+        // move each center towards the cells assigned to it, with a decreasing learning rate
+        for (int b = 0; b != _batchSize; ++b)
+        {
+            int c = nearestv[b];
+            double eta = 1. / ++countv[c];
+            double* cv = &centers(c, 0);
+            const double* xv = &features(b, 0);
+            for (int i = 0; i != numFeatures; ++i) cv[i] += eta * (xv[i] - cv[i]);
+        }
+    }
+    random->pop();
+
+    // map each cell to the nearest center in parallel, remembering the squared distance
+    Array distancev(numUsed);
+    parallel->call(numUsed, [&](size_t firstIndex, size_t numIndices) {
+        vector<double> xv(numFeatures);
+        for (size_t i = firstIndex; i != firstIndex + numIndices; ++i)
+        {
+            storeFeatures(xv.data(), mv[i], ms, dlambdav);
+            nv[mv[i]] = nearestCenter(xv.data(), centers, _numClusters, numFeatures, distancev[i]);
+        }
+    });
+
+    // calculate the rms distance between the cells and their cluster center for each library entry,
+    // and the luminosity-weighted rms distance over all cells
+    vector<int> mappedv(_numClusters);
+    Array sumv(_numClusters);
+    double sumL = 0.;
+    for (int i = 0; i != numUsed; ++i)
+    {
+        int n = nv[mv[i]];
+        mappedv[n]++;
+        sumv[n] += distancev[i];
+        sumL += bv[mv[i]] * distancev[i];
+    }
+    int usedEntries = 0;
+    int worstEntry = 0;
+    double worstError = 0.;
+    for (int n = 0; n != _numClusters; ++n)
+    {
+        if (mappedv[n])
+        {
+            usedEntries++;
+            double error = sqrt(sumv[n] / mappedv[n]);
+            if (error > worstError)
+            {
+                worstError = error;
+                worstEntry = n;
+            }
+        }
+    }
+
+    // log the approximation errors
+    log->info("  Using " + std::to_string(usedEntries) + " out of " + std::to_string(_numClusters)
+              + " library entries");
+    log->info("  RMS distance to cluster center averaged over cells: "
+              + StringUtils::toString(sqrt(sumv.sum() / numUsed), 'g', 4));
+    log->info("  RMS distance to cluster center weighted by luminosity: "
+              + StringUtils::toString(sqrt(sumL / Ltot), 'g', 4));
+    log->info("  RMS distance to cluster center for worst entry: " + StringUtils::toString(worstError, 'g', 4)
+              + " (" + std::to_string(mappedv[worstEntry]) + " cells)");
+    return nv;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,95 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef SPECTRALCLUSTERCELLLIBRARY_HPP
+#define SPECTRALCLUSTERCELLLIBRARY_HPP
+
+#include "SpatialCellLibrary.hpp"
+
+//////////////////////////////////////////////////////////////////////
+
+/** The SpectralClusterCellLibrary class provides a library scheme for grouping spatial cells based
+    on both the strength and the spectral shape of the stored radiation field. Rather than binning
+    one or two scalar indicators on a predefined grid, the library groups cells by clustering a
+    multi-dimensional representation of their radiation fields using the mini-batch \f$k\f$-means
+    algorithm (Sculley 2010, Proceedings of the 19th International Conference on World Wide Web,
+    1177). As a result, cells with a similar field strength but a different spectral hardness can
+    be assigned to different library entries, and the library entries are concentrated in the
+    regions of parameter space that are actually populated by the cells in the simulation.
+
+    The radiation field in cell \f$m\f$ is represented by a feature vector with
+    \f$N_\lambda+1\f$ components, where \f$N_\lambda\f$ is the number of bins in the radiation
+    field wavelength grid. The first component is \f$\log_{10} U_m\f$, where \f$U_m\f$ is the
+    field strength relative to the local interstellar radiation field in the Milky Way as defined
+    for the FieldStrengthCellLibrary class. The remaining components are the square roots of the
+    fractions of the bolometric mean intensity contained in each wavelength bin, \f[ x_{m,\ell} =
+    \sqrt{ \frac{ J_{m,\ell}\,\Delta\lambda_\ell }{ \sum_{\ell'} J_{m,\ell'}\,\Delta\lambda_{\ell'}
+    } }. \f] The Euclidean distance between the shape components of two feature vectors is thus
+    proportional to the Hellinger distance between the normalized spectra, which varies between
+    zero for identical shapes and \f$\sqrt{2}\f$ for spectra without overlap. A difference of
+    one dex in field strength contributes a distance of one unit.
+
+    Cells with a field strength below \f$U=10^{-6}\f$ are not mapped to a library entry, as for the
+    FieldStrengthCellLibrary class. If the number of remaining cells does not exceed the configured
+    number of library entries, each of these cells is simply given its own entry. Otherwise, the
+    cluster centers are initialized to the feature vectors of randomly selected cells, and then
+    refined during a configurable number of iterations. Cells are selected with a probability that
+    is for one half uniform and for the other half proportional to the cell's luminosity, so that
+    the clusters resolve the cells that dominate the emission in more detail while still covering
+    the remaining cells. Each iteration draws a random sample of cells, assigns each sampled cell to
+    its nearest center, and moves each affected center towards the sampled feature vector with a
+    per-center learning rate equal to the inverse of the number of cells assigned to it so far.
+    Finally, each cell is mapped to the library entry corresponding to its nearest cluster center.
+    The random sequences are obtained from a generator with a fixed seed, so that all processes in a
+    multi-process simulation construct the same mapping.
+
+    After the mapping has been established, the function logs the root-mean-square distance in
+    feature space between the cells and the center of their cluster, averaged over all mapped cells,
+    weighted by the cell luminosity, and for the worst library entry, as an indication of the
+    approximation error introduced by the library. */
+class SpectralClusterCellLibrary : public SpatialCellLibrary
+{
+    ITEM_CONCRETE(SpectralClusterCellLibrary, SpatialCellLibrary,
+                  "a library scheme for grouping spatial cells by clustering radiation field strength and shape")
+        ATTRIBUTE_TYPE_INSERT(SpectralClusterCellLibrary, "NonIdentitySpatialCellLibrary")
+
+        PROPERTY_INT(numClusters, "the number of library entries (radiation field clusters)")
+        ATTRIBUTE_MIN_VALUE(numClusters, "1")
+        ATTRIBUTE_MAX_VALUE(numClusters, "10000000")
+        ATTRIBUTE_DEFAULT_VALUE(numClusters, "1000")
+
+        PROPERTY_INT(numIterations, "the number of mini-batch k-means iterations")
+        ATTRIBUTE_MIN_VALUE(numIterations, "1")
+        ATTRIBUTE_MAX_VALUE(numIterations, "100000")
+        ATTRIBUTE_DEFAULT_VALUE(numIterations, "100")
+        ATTRIBUTE_DISPLAYED_IF(numIterations, "Level3")
+
+        PROPERTY_INT(batchSize, "the number of cells sampled in each mini-batch k-means iteration")
+        ATTRIBUTE_MIN_VALUE(batchSize, "100")
+        ATTRIBUTE_MAX_VALUE(batchSize, "10000000")
+        ATTRIBUTE_DEFAULT_VALUE(batchSize, "1000")
+        ATTRIBUTE_DISPLAYED_IF(batchSize, "Level3")
+
+    ITEM_END()
+
+    //======================== Other Functions =======================
+
+protected:
+    /** This function returns the number of entries in the library. In this class the function
+        returns the user-configured number of clusters. */
+    int numEntries() const override;
+
+    /** This function returns a vector \em nv with length \f$N_{\text{cells}}\f$ that maps each
+        cell index \f$m\f$ to the corresponding library entry index \f$n_m\f$. In this class the
+        function clusters the feature vectors representing the radiation field in each cell as
+        described in the class header, and maps each cell to the cluster with the nearest center.
+        The calculations for the sampled cells in each iteration and for the final mapping are
+        performed in parallel. */
+    vector<int> mapping(const Array& bv) const override;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -13,7 +13,6 @@
 #include "ParallelFactory.hpp"
 #include "PlanckFunction.hpp"
 #include "ProcessManager.hpp"
-#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -24,20 +23,46 @@ namespace
     template<typename T> class Square
     {
     private:
-        size_t _n;
-        T* _v;
+        size_t _n{0};
+        size_t _capacity{0};
+        T* _v{nullptr};
 
     public:
-        // constructor sets maximum size and logical size
-        Square(size_t n) : _n(n), _v(new T[n * n]) {}
+        // constructor creates an empty matrix; memory is allocated by resize()
+        Square() {}
         ~Square() { delete[] _v; }
 
-        // sets logical size, which must not be larger than maximum size set in constructor (is not checked)
-        // does not clear values; does not resize underlying memory
-        void resize(size_t n) { _n = n; }
+        // copying is not allowed
+        Square(const Square&) = delete;
+        Square& operator=(const Square&) = delete;
+
+        // sets logical size, growing the underlying memory if needed but never shrinking it;
+        // does not preserve or clear values
+        void resize(size_t n)
+        {
+            if (n * n > _capacity)
+            {
+                delete[] _v;
+                _capacity = n * n;
+                _v = new T[_capacity];
+            }
+            _n = n;
+        }
 
         // access to values  (const version currently not needed)
         T& operator()(size_t i, size_t j) { return _v[i * _n + j]; }
+
+        // access to a row of values
+        T* row(size_t i) { return _v + i * _n; }
+
+        // releases the underlying memory
+        void release()
+        {
+            delete[] _v;
+            _v = nullptr;
+            _capacity = 0;
+            _n = 0;
+        }
     };
 
     // square matrix with only items below the diagonal (i>j)
@@ -56,10 +81,35 @@ namespace
         const T& operator()(size_t i, size_t j) const { return _v[offset(i) + j]; }
         T& operator()(size_t i, size_t j) { return _v[offset(i) + j]; }
     };
+
 }
 
 ////////////////////////////////////////////////////////////////////
 
+// helper class holding scratch memory for the emissivity calculation; the calculator keeps a separate instance
+// for each execution thread so that calls to the emissivity() function don't need to allocate fresh memory
+class SDE_Workspace
+{
+public:
+    Square<double> _Am;       // cumulative transition matrix coefficients (indexed on f,i)
+    vector<double> _Pv;       // temperature probabilities (indexed on p - ioff)
+    Array _Jcmbv;             // radiation field including the CMB, if needed (indexed on k)
+    Array _Bsumv;             // probability-weighted black-body spectrum (indexed on ell)
+    vector<double> _eqMassv;  // mass above which grains are in equilibrium (indexed on grain type)
+
+    // release all allocated memory
+    void release()
+    {
+        _Am.release();
+        vector<double>().swap(_Pv);
+        _Jcmbv.resize(0);
+        _Bsumv.resize(0);
+        vector<double>().swap(_eqMassv);
+    }
+};
+
+////////////////////////////////////////////////////////////////////
+
 // helper class to construct and store a particular temperature grid and the black-body emissivity spectrum
 // discretized on this temperature grid and on the output wavelength grid;
 // all members are public for ease of use in SDE_Calculator
@@ -146,12 +196,19 @@ public:
                 double Hdiff = Hv[f] - Hv[i];
                 double lambda = hc / Hdiff;
                 int k = rfWLG->bin(lambda);
-                _Km(f, i) = k;
+                // for transitions outside of the radiation field wavelength grid, store a zero heating rate
+                // with a valid wavelength index so that calcProbs() does not need to test for this case
                 if (k >= 0)
                 {
                     double sigmaabs = NR::value<NR::interpolateLogLog>(lambda, lambdav, sigmaabsv);
+                    _Km(f, i) = k;
                     _HRm(f, i) = hc * sigmaabs * dHv[f] / (Hdiff * Hdiff * Hdiff);
                 }
+                else
+                {
+                    _Km(f, i) = 0;
+                    _HRm(f, i) = 0.;
+                }
             }
         }
 
@@ -234,79 +291,105 @@ public:
     // Tmin/Tmax: temperature range in which to perform the calculation (in), and
     //            temperature range where the calculated probabilities are above a certain fraction of maximum (out)
     // Jv: the radiation field discretized on the input wavelength grid (in)
-    void calcProbs(Array& Pv, int& ioff, Square<double>& Am, double& Tmin, double& Tmax, const Array& Jv) const
+    void calcProbs(vector<double>& Pv, int& ioff, Square<double>& Am, double& Tmin, double& Tmax,
+                   const Array& Jv) const
     {
         ioff = NR::locateClip(_grid->_Tv, Tmin);
         int NT = NR::locateClip(_grid->_Tv, Tmax) - ioff + 2;
 
-        // copy/calculate the transition matrix coefficients
+        // calculate the cumulative transition matrix coefficients in a single pass, starting with the last row;
+        // each row is stored contiguously and the loops have no branches, so that the compiler can vectorize them
         Am.resize(NT);
-        for (int f = 1; f < NT; f++)
+        const double* J = &Jv[0];
+        for (int f = NT - 1; f > 0; f--)
         {
             const short* Kv = &_Km(f + ioff, ioff);
             const double* HRv = &_HRm(f + ioff, ioff);
-            for (int i = 0; i < f; i++)
+            double* Av = Am.row(f);
+            if (f == NT - 1)
             {
-                int k = Kv[i];
-                Am(f, i) = k >= 0 ? HRv[i] * Jv[k] : 0.;
+                for (int i = 0; i < f; i++) Av[i] = HRv[i] * J[Kv[i]];
             }
-        }
-        for (int i = 1; i < NT; i++)
-        {
-            Am(i - 1, i) = _CRv[i + ioff];
-        }
-
-        // calculate the cumulative matrix coefficients, in place
-        for (int f = NT - 2; f > 0; f--)
-        {
-            for (int i = 0; i < f; i++)
+            else
             {
-                Am(f, i) += Am(f + 1, i);
+                const double* Anextv = Am.row(f + 1);
+                for (int i = 0; i < f; i++) Av[i] = HRv[i] * J[Kv[i]] + Anextv[i];
             }
         }
 
-        // calculate the probabilities
+        // calculate the probabilities; the cooling rates are taken directly from the precalculated array
         Pv.resize(NT);
-        Pv[0] = 1.;
+        double* P = Pv.data();
+        P[0] = 1.;
         for (int i = 1; i < NT; i++)
         {
-            double sum = 0.;
-            for (int j = 0; j < i; j++) sum += Am(i, j) * Pv[j];
-            Pv[i] = sum / Am(i - 1, i);
+            // use independent partial sums so that the compiler can vectorize the inner product
+            const double* Av = Am.row(i);
+            double sum0 = 0., sum1 = 0., sum2 = 0., sum3 = 0.;
+            int j = 0;
+            for (; j + 4 <= i; j += 4)
+            {
+                sum0 += Av[j] * P[j];
+                sum1 += Av[j + 1] * P[j + 1];
+                sum2 += Av[j + 2] * P[j + 2];
+                sum3 += Av[j + 3] * P[j + 3];
+            }
+            for (; j < i; j++) sum0 += Av[j] * P[j];
+            P[i] = ((sum0 + sum1) + (sum2 + sum3)) / _CRv[i + ioff];
 
             // rescale if needed to keep infinities from happening
-            if (Pv[i] > 1e10)
-                for (int j = 0; j <= i; j++) Pv[j] /= Pv[i];
+            if (P[i] > 1e10)
+            {
+                double Pi = P[i];
+                for (int j = 0; j <= i; j++) P[j] /= Pi;
+            }
         }
 
         // normalize probabilities to unity
-        Pv /= Pv.sum();
+        double Psum = 0.;
+        double Pmax = 0.;
+        for (int i = 0; i < NT; i++)
+        {
+            Psum += P[i];
+            Pmax = max(Pmax, P[i]);
+        }
+        for (int i = 0; i < NT; i++) P[i] /= Psum;
 
         // determine the temperature range where the probabability is above a given fraction of its maximum
-        double frac = 1e-20 * Pv.max();
+        double frac = 1e-20 * Pmax / Psum;
         int k;
         for (k = 0; k != NT - 2; k++)
-            if (Pv[k] > frac) break;
+            if (P[k] > frac) break;
         Tmin = _grid->_Tv[k + ioff];
         for (k = NT - 2; k != 1; k--)
-            if (Pv[k] > frac) break;
+            if (P[k] > frac) break;
         Tmax = _grid->_Tv[k + 1 + ioff];
     }
 
     // add the stochastic emissivity of the population (assumes that calcProbs has been called)
     // ev: the accumulated emissivity (in/out)
+    // Bsumv: scratch memory for the calculation (internal only)
     // Tmin/Tmax: temperature range in which to add radiation (in)
     // Pv: the probabilities calculated previously by this calculator (in)
     // ioff: the index offset in the temperature grid used for that previous calculation (in)
-    void addStochastic(Array& ev, double Tmin, double Tmax, const Array& Pv, int ioff) const
+    void addStochastic(Array& ev, Array& Bsumv, double Tmin, double Tmax, const vector<double>& Pv, int ioff) const
     {
         int imin = NR::locateClip(_grid->_Tv, Tmin);
         int imax = NR::locateClip(_grid->_Tv, Tmax);
 
+        // accumulate the black-body spectra weighted by probability, and multiply by the cross section only once
+        int numLambda = _emlambdav.size();
+        if (Bsumv.size() != static_cast<size_t>(numLambda)) Bsumv.resize(numLambda);
+        double* Bsum = &Bsumv[0];
+        for (int ell = 0; ell != numLambda; ++ell) Bsum[ell] = 0.;
         for (int i = imin; i <= imax; i++)
         {
-            ev += _emsigmaabsv * _grid->_Bvv[i] * Pv[i - ioff];
+            const double* Bv = &_grid->_Bvv[i][0];
+            double P = Pv[i - ioff];
+            for (int ell = 0; ell != numLambda; ++ell) Bsum[ell] += P * Bv[ell];
         }
+        const double* sigma = &_emsigmaabsv[0];
+        for (int ell = 0; ell != numLambda; ++ell) ev[ell] += sigma[ell] * Bsum[ell];
     }
 };
 
@@ -345,6 +428,7 @@ StochasticDustEmissionCalculator::~StochasticDustEmissionCalculator()
     delete _gridA;
     delete _gridB;
     delete _gridC;
+    for (auto workspace : _workspaces.all()) workspace->release();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -404,7 +488,9 @@ void StochasticDustEmissionCalculator::precalculate(SimulationItem* item, const
 
     // remember some other properties for this bin
     _meanMasses.push_back(meanMass);
-    _grainTypes.push_back(grainType);
+    auto type = std::find(_grainTypes.begin(), _grainTypes.end(), grainType);
+    _grainTypeIndices.push_back(type - _grainTypes.begin());
+    if (type == _grainTypes.end()) _grainTypes.push_back(grainType);
     _maxEnthalpyTemps.push_back(enthalpy.axisRange<0>().max());
 }
 
@@ -427,6 +513,7 @@ size_t StochasticDustEmissionCalculator::allocatedBytes() const
 
     allocatedBytes += _meanMasses.size() * sizeof(_meanMasses[0]);
     allocatedBytes += _grainTypes.size() * sizeof(_grainTypes[0]);
+    allocatedBytes += _grainTypeIndices.size() * sizeof(_grainTypeIndices[0]);
     allocatedBytes += _maxEnthalpyTemps.size() * sizeof(_maxEnthalpyTemps[0]);
     return allocatedBytes;
 }
@@ -435,23 +522,26 @@ size_t StochasticDustEmissionCalculator::allocatedBytes() const
 
 Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
 {
-    // if requested, create a local copy of the input radiation field that includes the CMB;
-    // constructing a reference to either the input or this local copy avoids copying the input if there is no CMB
-    Array Jcmbv;
-    if (_Bcmbv.size()) Jcmbv = Jv + _Bcmbv;
-    const Array& myJv = _Bcmbv.size() ? Jcmbv : Jv;
+    // get the scratch memory for this execution thread
+    SDE_Workspace& ws = *_workspaces.local();
 
-    // accumulate the emissivities in this array
+    // if requested, construct a copy of the input radiation field that includes the CMB;
+    // constructing a reference to either the input or this copy avoids copying the input if there is no CMB
+    size_t numWavelengths = _Bcmbv.size();
+    if (numWavelengths)
+    {
+        if (ws._Jcmbv.size() != numWavelengths) ws._Jcmbv.resize(numWavelengths);
+        for (size_t k = 0; k != numWavelengths; ++k) ws._Jcmbv[k] = Jv[k] + _Bcmbv[k];
+    }
+    const Array& myJv = numWavelengths ? ws._Jcmbv : Jv;
+
+    // the resulting emissivity spectrum, initialized to zero
     Array ev(_emlambdav.size());
 
-    // this dictionary is updated as the loop over all bins in the mix proceeds;
+    // this table is updated as the loop over all bins in the mix proceeds;
     // for each type of grain composition, it keeps track of the grain mass above which
     // the representative grain is most certainly in equilibrium
-    std::unordered_map<string, double> eqMass;
-
-    // provide room for the probabilities calculated over each of the temperature grids
-    Array Pv;
-    Square<double> Am(static_cast<size_t>(ceil(Tuppermax)) + 1);
+    ws._eqMassv.assign(_grainTypes.size(), std::numeric_limits<double>::infinity());
 
     // loop over all representative grains (size bins) in the dust mix
     int numBins = _calculatorsA.size();
@@ -461,16 +551,16 @@ Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
         double Teq = _calculatorsC[b]->equilibriumTemperature(myJv);
 
         // consider stochastic calculation only if the mean mass for this bin is below the cutoff mass
-        string grainType = _grainTypes[b];
+        double& eqMass = ws._eqMassv[_grainTypeIndices[b]];
         double meanmass = _meanMasses[b];
-        if (!eqMass.count(grainType) || meanmass < eqMass.at(grainType))
+        if (meanmass < eqMass)
         {
             // calculate the probabilities over the coarse temperature grid
             double Tmin = 0;
             double Tmax = min(Tuppermax, _maxEnthalpyTemps[b]);
 
             int ioff = 0;
-            _calculatorsA[b]->calcProbs(Pv, ioff, Am, Tmin, Tmax, myJv);
+            _calculatorsA[b]->calcProbs(ws._Pv, ioff, ws._Am, Tmin, Tmax, myJv);
 
             // if the population might be stochastic...
             if (Tmax - Tmin > deltaTeq && Teq < Tmax)
@@ -479,19 +569,19 @@ Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
                 const SDE_Calculator* calculator = (Tmax - Tmin > deltaTmedium) ? _calculatorsB[b] : _calculatorsC[b];
 
                 // calculate the probabilities over this grid, in the range determined by the coarse calculation
-                calculator->calcProbs(Pv, ioff, Am, Tmin, Tmax, myJv);
+                calculator->calcProbs(ws._Pv, ioff, ws._Am, Tmin, Tmax, myJv);
 
                 // if the population indeed is stochastic...
                 if (Tmax - Tmin > deltaTeq && Teq < Tmax)
                 {
                     // add the stochastic emissivity of this population to the running total
-                    calculator->addStochastic(ev, Tmin, Tmax, Pv, ioff);
+                    calculator->addStochastic(ev, ws._Bsumv, Tmin, Tmax, ws._Pv, ioff);
                     continue;
                 }
             }
 
             // remember that all grains above this mass will be in equilibrium
-            eqMass[grainType] = meanmass;
+            eqMass = meanmass;
         }
 
         // otherwise, add the equilibrium emissivity of this population to the running total
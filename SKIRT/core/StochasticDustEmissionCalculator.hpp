@@ -8,9 +8,11 @@
 
 #include "Array.hpp"
 #include "StoredTable.hpp"
+#include "ThreadLocalMember.hpp"
 class SimulationItem;
 class SDE_Calculator;
 class SDE_TemperatureGrid;
+class SDE_Workspace;
 
 ////////////////////////////////////////////////////////////////////
 
@@ -87,7 +89,8 @@ class SDE_TemperatureGrid;
 class StochasticDustEmissionCalculator
 {
 public:
-    /** The destructor destructs the data structures allocated by the precalculate() function. */
+    /** The destructor destructs the data structures allocated by the precalculate() function and
+        releases the scratch memory allocated by the emissivity() function. */
     ~StochasticDustEmissionCalculator();
 
     /** This function precalculates and stores information used to calculate the emissivity
@@ -127,7 +130,12 @@ public:
         stochastically heated dust grains. The input and output arrays are discretized on the
         wavelength grids returned by the Configuration::radiationFieldWLG() and
         Configuration::dustEmissionWLG() functions, repectively. If the precalculate() function has
-        not been called for at least one bin, the behavior of this function is undefined. */
+        not been called for at least one bin, the behavior of this function is undefined.
+
+        The scratch memory used by the calculation is allocated for each execution thread on first
+        use and reused for subsequent calls on that thread, so that the function can be called
+        concurrently from multiple threads without allocating fresh memory for each call. This
+        memory is released when the calculator is destructed. */
     Array emissivity(const Array& Jv) const;
 
     //======================== Data Members ========================
@@ -150,9 +158,15 @@ private:
     vector<const SDE_Calculator*> _calculatorsC;  // fine grid
 
     // other properties for each representative dust grain (size bin) -- indexed on b
-    vector<string> _grainTypes;        // the grain type identifier
+    vector<int> _grainTypeIndices;     // index of the grain type identifier in _grainTypes
     vector<double> _meanMasses;        // mean mass of a grain
     vector<double> _maxEnthalpyTemps;  // maximum temperature for the enthalpy data
+
+    // the distinct grain type identifiers -- indexed on grain type index
+    vector<string> _grainTypes;
+
+    // scratch memory for the emissivity calculation -- one instance for each execution thread
+    mutable ThreadLocalMember<SDE_Workspace> _workspaces;
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -4,7 +4,11 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "TreeSpatialGrid.hpp"
+#include "Configuration.hpp"
+#include "FatalError.hpp"
+#include "GridCache.hpp"
 #include "Log.hpp"
+#include "MediumSystem.hpp"
 #include "PathSegmentGenerator.hpp"
 #include "Random.hpp"
 #include "SpatialGridPath.hpp"
@@ -14,13 +18,6 @@
 
 ////////////////////////////////////////////////////////////////////
 
-TreeSpatialGrid::~TreeSpatialGrid()
-{
-    for (auto node : _nodev) delete node;
-}
-
-////////////////////////////////////////////////////////////////////
-
 void TreeSpatialGrid::setupSelfAfter()
 {
     BoxSpatialGrid::setupSelfAfter();
@@ -28,25 +25,39 @@ void TreeSpatialGrid::setupSelfAfter()
     // determine a small fraction relative to the spatial extent of the grid; used during path traversal
     _eps = 1e-12 * extent().widths().norm();
 
-    // make subclass construct the tree
-    Log* log = find<Log>();
-    log->info("Constructing the spatial tree grid...");
-    _nodev = constructTree();
+    // if caching is enabled, determine a cache key from the configuration of the grid and the media,
+    // and from the options that influence the random density sampling during tree construction
+    auto config = find<Configuration>();
+    uint64_t key = 0;
+    if (config->hasSpatialGridCache())
+    {
+        key = GridCache::hashItem(GridCache::initialHash(), this);
+        auto ms = find<MediumSystem>(false);
+        if (ms)
+            for (auto medium : ms->media()) key = GridCache::hashItem(key, medium);
+        key = GridCache::hash(key, config->numDensitySamples());
+        key = GridCache::hash(key, random()->seed());
+    }
 
-    // construct the vectors to help translating between node indices (leaf and nonleaf) and cell indices (leaf only)
-    //  _cellindexv : cell index m corresponding to each node in nodev; -1 for nonleaf nodes
-    //  _idv;       : index in nodev for each cell (i.e. leaf node); corresponds to node ID
-    int numNodes = _nodev.size();
-    int m = 0;
-    _cellindexv.resize(numNodes, -1);
-    for (int l = 0; l != numNodes; ++l)
+    // load the flattened tree from the cache, if possible
+    Log* log = find<Log>();
+    GridCache cache(this, "tree", key);
+    if (cache.load())
     {
-        if (_nodev[l]->isChildless())
-        {
-            _idv.push_back(l);
-            _cellindexv[l] = m;
-            m++;
-        }
+        loadTree(cache);
+    }
+    else
+    {
+        // make subclass construct the tree
+        log->info("Constructing the spatial tree grid...");
+        vector<TreeNode*> nodev = constructTree();
+
+        // convert the tree to its flattened representation and release the tree nodes
+        flattenTree(nodev);
+        for (auto node : nodev) delete node;
+
+        // store the flattened tree in the cache, if enabled
+        saveTree(cache);
     }
 
     // determine the number of cells at each level in the tree hierarchy
@@ -54,7 +65,7 @@ void TreeSpatialGrid::setupSelfAfter()
     int numCells = _idv.size();
     for (int m = 0; m != numCells; ++m)
     {
-        int level = nodeForCellIndex(m)->level();
+        int level = _levelv[m];
         if (level + 1 > static_cast<int>(countv.size())) countv.resize(level + 1);
         countv[level]++;
     }
@@ -77,6 +88,86 @@ void TreeSpatialGrid::setupSelfAfter()
 
 ////////////////////////////////////////////////////////////////////
 
+void TreeSpatialGrid::flattenTree(const vector<TreeNode*>& nodev)
+{
+    int numNodes = nodev.size();
+
+    // copy the node bounds and the index of the first child
+    _xminv.resize(numNodes);
+    _yminv.resize(numNodes);
+    _zminv.resize(numNodes);
+    _xmaxv.resize(numNodes);
+    _ymaxv.resize(numNodes);
+    _zmaxv.resize(numNodes);
+    _childv.resize(numNodes, -1);
+    for (int n = 0; n != numNodes; ++n)
+    {
+        const TreeNode* node = nodev[n];
+        if (node->id() != n) throw FATALERROR("Tree node ID does not match its index in the node list");
+        node->extent(_xminv[n], _yminv[n], _zminv[n], _xmaxv[n], _ymaxv[n], _zmaxv[n]);
+
+        const auto& children = node->children();
+        if (!children.empty())
+        {
+            int first = children[0]->id();
+            int numChildren = children.size();
+            for (int l = 0; l != numChildren; ++l)
+                if (children[l]->id() != first + l) throw FATALERROR("Tree node children do not have consecutive IDs");
+            _childv[n] = first;
+        }
+    }
+
+    // verify that the children of each node are organized as assumed by the childNode() function
+    for (int n = 0; n != numNodes; ++n)
+    {
+        const auto& children = nodev[n]->children();
+        int numChildrenNode = children.size();
+        if (numChildrenNode && numChildren(n) != numChildrenNode)
+            throw FATALERROR("Tree node is not split into halves along one or more axes");
+        for (int l = 0; l != numChildrenNode; ++l)
+            if (childNode(n, children[l]->extent().center()) != _childv[n] + l)
+                throw FATALERROR("Tree node children are not ordered as expected");
+    }
+
+    // pack the neighbor lists for all nodes and walls; the cumulative count is kept in 64 bits to detect overflow
+    _nbroffsetv.resize(6 * numNodes + 1);
+    size_t numNeighbors = 0;
+    for (int n = 0; n != numNodes; ++n)
+    {
+        for (int w = 0; w != 6; ++w)
+        {
+            _nbroffsetv[6 * n + w] = numNeighbors;
+            numNeighbors += nodev[n]->neighbors(static_cast<TreeNode::Wall>(w)).size();
+            if (numNeighbors > static_cast<size_t>(std::numeric_limits<int>::max()))
+                throw FATALERROR("Too many neighbor links in the spatial tree grid");
+        }
+    }
+    _nbroffsetv[6 * numNodes] = numNeighbors;
+    _nbrv.reserve(numNeighbors);
+    for (int n = 0; n != numNodes; ++n)
+        for (int w = 0; w != 6; ++w)
+            for (auto neighbor : nodev[n]->neighbors(static_cast<TreeNode::Wall>(w))) _nbrv.push_back(neighbor->id());
+
+    // construct the vectors to help translating between node indices (leaf and nonleaf) and cell indices (leaf only)
+    //  _cellindexv : cell index m corresponding to each node; -1 for nonleaf nodes
+    //  _idv        : node ID for each cell (i.e. leaf node)
+    //  _levelv     : level in the tree hierarchy for each cell (i.e. leaf node)
+    _cellindexv.resize(numNodes, -1);
+    for (int n = 0; n != numNodes; ++n)
+    {
+        if (_childv[n] < 0)
+        {
+            _cellindexv[n] = _idv.size();
+            _idv.push_back(n);
+            _levelv.push_back(nodev[n]->level());
+        }
+    }
+    _idv.shrink_to_fit();
+    _levelv.shrink_to_fit();
+}
+
+////////////////////////////////////////////////////////////////////
+
 int TreeSpatialGrid::numCells() const
 {
     return _idv.size();
@@ -86,36 +177,36 @@ int TreeSpatialGrid::numCells() const
 
 double TreeSpatialGrid::volume(int m) const
 {
-    return nodeForCellIndex(m)->volume();
+    return nodeExtent(_idv[m]).volume();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double TreeSpatialGrid::diagonal(int m) const
 {
-    return nodeForCellIndex(m)->diagonal();
+    return nodeExtent(_idv[m]).diagonal();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 int TreeSpatialGrid::cellIndex(Position bfr) const
 {
-    const TreeNode* node = root()->leafChild(bfr);
-    return node ? cellIndexForNode(node) : -1;
+    int n = leafNode(bfr);
+    return n >= 0 ? _cellindexv[n] : -1;
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position TreeSpatialGrid::centralPositionInCell(int m) const
 {
-    return Position(nodeForCellIndex(m)->extent().center());
+    return Position(nodeExtent(_idv[m]).center());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position TreeSpatialGrid::randomPositionInCell(int m) const
 {
-    return random()->position(nodeForCellIndex(m)->extent());
+    return random()->position(nodeExtent(_idv[m]));
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -123,7 +214,7 @@ Position TreeSpatialGrid::randomPositionInCell(int m) const
 class TreeSpatialGrid::MySegmentGenerator : public PathSegmentGenerator
 {
     const TreeSpatialGrid* _grid{nullptr};
-    const TreeNode* _node{nullptr};
+    int _n{-1};  // the ID of the current node
 
 public:
     MySegmentGenerator(const TreeSpatialGrid* grid) : _grid(grid) {}
@@ -138,7 +229,7 @@ public:
                 if (!moveInside(_grid->extent(), _grid->_eps)) return false;
 
                 // get the node containing the current location;
-                _node = _grid->root()->leafChild(r());
+                _n = _grid->leafNode(r());
 
                 // if the photon packet started outside the grid, return the corresponding nonzero-length segment;
                 // otherwise fall through to determine the first actual segment
@@ -150,9 +241,9 @@ public:
             {
                 // determine the segment from the current position to the first cell wall
                 // and adjust the position and cell indices accordingly
-                double xnext = (kx() < 0.0) ? _node->xmin() : _node->xmax();
-                double ynext = (ky() < 0.0) ? _node->ymin() : _node->ymax();
-                double znext = (kz() < 0.0) ? _node->zmin() : _node->zmax();
+                double xnext = (kx() < 0.0) ? _grid->_xminv[_n] : _grid->_xmaxv[_n];
+                double ynext = (ky() < 0.0) ? _grid->_yminv[_n] : _grid->_ymaxv[_n];
+                double znext = (kz() < 0.0) ? _grid->_zminv[_n] : _grid->_zmaxv[_n];
                 double dsx = (fabs(kx()) > 1e-15) ? (xnext - rx()) / kx() : DBL_MAX;
                 double dsy = (fabs(ky()) > 1e-15) ? (ynext - ry()) / ky() : DBL_MAX;
                 double dsz = (fabs(kz()) > 1e-15) ? (znext - rz()) / kz() : DBL_MAX;
@@ -175,27 +266,27 @@ public:
                     wall = (kz() < 0.0) ? TreeNode::BOTTOM : TreeNode::TOP;
                 }
                 propagater(ds + _grid->_eps);
-                setSegment(_grid->cellIndexForNode(_node), ds);
+                setSegment(_grid->_cellindexv[_n], ds);
 
                 // attempt to find the new node among the neighbors of the current node;
                 // this should not fail unless the new location is outside the grid,
                 // however on rare occasions it fails due to rounding errors (e.g. in a corner),
                 // thus we use top-down search as a fall-back
-                const TreeNode* oldnode = _node;
-                _node = _node->neighbor(wall, r());
-                if (!_node) _node = _grid->root()->leafChild(r());
+                int oldn = _n;
+                _n = _grid->neighborNode(_n, wall, r());
+                if (_n < 0) _n = _grid->leafNode(r());
 
                 // if we're stuck in the same node,
                 // try to escape by advancing the position to the next representable coordinates
-                if (_node == oldnode)
+                if (_n == oldn)
                 {
                     // try to escape by advancing the position to the next representable coordinates
                     propagateToNextAfter();
-                    _node = _grid->root()->leafChild(r());
+                    _n = _grid->leafNode(r());
                 }
 
                 // if we're outside the domain or still stuck in the same node, terminate the path
-                if (!_node || _node == oldnode) setState(State::Outside);
+                if (_n < 0 || _n == oldn) setState(State::Outside);
                 return true;
             }
 
@@ -216,19 +307,16 @@ std::unique_ptr<PathSegmentGenerator> TreeSpatialGrid::createPathSegmentGenerato
 
 ////////////////////////////////////////////////////////////////////
 
-namespace
+void TreeSpatialGrid::writeTopologyForNode(int n, TextOutFile* outfile) const
 {
-    // this function writes a "0" for a leaf node or a "1" for a nonleaf node
-    // followed by the recursive topological representation of its children
-    void writeTopologyForNode(TreeNode* node, TextOutFile* outfile)
+    if (_childv[n] < 0)
+        outfile->writeLine("0");
+    else
     {
-        if (node->isChildless())
-            outfile->writeLine("0");
-        else
-        {
-            outfile->writeLine("1");
-            for (auto child : node->children()) writeTopologyForNode(child, outfile);
-        }
+        outfile->writeLine("1");
+        int first = _childv[n];
+        int numChildrenNode = numChildren(n);
+        for (int l = 0; l != numChildrenNode; ++l) writeTopologyForNode(first + l, outfile);
     }
 }
 
@@ -237,8 +325,8 @@ namespace
 void TreeSpatialGrid::writeTopology(TextOutFile* outfile) const
 {
     outfile->writeLine("# Topology for tree spatial grid with " + std::to_string(numCells()) + " cells");
-    outfile->writeLine(std::to_string(root()->children().size()));  // zero if the root node is not subdivided
-    writeTopologyForNode(root(), outfile);
+    outfile->writeLine(std::to_string(numChildren(0)));  // zero if the root node is not subdivided
+    writeTopologyForNode(0, outfile);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -250,10 +338,10 @@ void TreeSpatialGrid::write_xy(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m = 0; m != nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (fabs(node->zmin()) < 1e-8 * extent().zwidth())
+        int n = _idv[m];
+        if (fabs(_zminv[n]) < 1e-8 * extent().zwidth())
         {
-            outfile->writeRectangle(node->xmin(), node->ymin(), node->xmax(), node->ymax());
+            outfile->writeRectangle(_xminv[n], _yminv[n], _xmaxv[n], _ymaxv[n]);
         }
     }
 }
@@ -267,10 +355,10 @@ void TreeSpatialGrid::write_xz(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m = 0; m != nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (fabs(node->ymin()) < 1e-8 * extent().ywidth())
+        int n = _idv[m];
+        if (fabs(_yminv[n]) < 1e-8 * extent().ywidth())
         {
-            outfile->writeRectangle(node->xmin(), node->zmin(), node->xmax(), node->zmax());
+            outfile->writeRectangle(_xminv[n], _zminv[n], _xmaxv[n], _zmaxv[n]);
         }
     }
 }
@@ -284,10 +372,10 @@ void TreeSpatialGrid::write_yz(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m = 0; m != nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (fabs(node->xmin()) < 1e-8 * extent().xwidth())
+        int n = _idv[m];
+        if (fabs(_xminv[n]) < 1e-8 * extent().xwidth())
         {
-            outfile->writeRectangle(node->ymin(), node->zmin(), node->ymax(), node->zmax());
+            outfile->writeRectangle(_yminv[n], _zminv[n], _ymaxv[n], _zmaxv[n]);
         }
     }
 }
@@ -301,7 +389,7 @@ void TreeSpatialGrid::write_xyz(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m = 0; m != nCells; ++m)
     {
-        int level = nodeForCellIndex(m)->level();
+        int level = _levelv[m];
         if (level + 1 > static_cast<int>(countv.size())) countv.resize(level + 1);
         countv[level]++;
     }
@@ -324,31 +412,121 @@ void TreeSpatialGrid::write_xyz(SpatialGridPlotFile* outfile) const
     // output all leaf cells up to a certain level
     for (int m = 0; m != nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (node->level() <= highestWriteLevel)
-            outfile->writeCube(node->xmin(), node->ymin(), node->zmin(), node->xmax(), node->ymax(), node->zmax());
+        int n = _idv[m];
+        if (_levelv[m] <= highestWriteLevel)
+            outfile->writeCube(_xminv[n], _yminv[n], _zminv[n], _xmaxv[n], _ymaxv[n], _zmaxv[n]);
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
-TreeNode* TreeSpatialGrid::root() const
+void TreeSpatialGrid::loadTree(const GridCache& cache)
+{
+    cache.get("xmin", _xminv);
+    cache.get("ymin", _yminv);
+    cache.get("zmin", _zminv);
+    cache.get("xmax", _xmaxv);
+    cache.get("ymax", _ymaxv);
+    cache.get("zmax", _zmaxv);
+    cache.get("child", _childv);
+    cache.get("nbroff", _nbroffsetv);
+    cache.get("nbr", _nbrv);
+    cache.get("cellidx", _cellindexv);
+    cache.get("id", _idv);
+    cache.get("level", _levelv);
+
+    // verify the consistency of the array sizes
+    size_t numNodes = _xminv.size();
+    if (!numNodes || _yminv.size() != numNodes || _zminv.size() != numNodes || _xmaxv.size() != numNodes
+        || _ymaxv.size() != numNodes || _zmaxv.size() != numNodes || _childv.size() != numNodes
+        || _nbroffsetv.size() != 6 * numNodes + 1 || _nbrv.size() != static_cast<size_t>(_nbroffsetv.back())
+        || _cellindexv.size() != numNodes || _levelv.size() != _idv.size())
+        throw FATALERROR("Inconsistent spatial tree grid data in cache file");
+}
+
+////////////////////////////////////////////////////////////////////
+
+void TreeSpatialGrid::saveTree(GridCache& cache) const
+{
+    cache.put("xmin", _xminv);
+    cache.put("ymin", _yminv);
+    cache.put("zmin", _zminv);
+    cache.put("xmax", _xmaxv);
+    cache.put("ymax", _ymaxv);
+    cache.put("zmax", _zmaxv);
+    cache.put("child", _childv);
+    cache.put("nbroff", _nbroffsetv);
+    cache.put("nbr", _nbrv);
+    cache.put("cellidx", _cellindexv);
+    cache.put("id", _idv);
+    cache.put("level", _levelv);
+    cache.save();
+}
+
+////////////////////////////////////////////////////////////////////
+
+Box TreeSpatialGrid::nodeExtent(int n) const
+{
+    return Box(_xminv[n], _yminv[n], _zminv[n], _xmaxv[n], _ymaxv[n], _zmaxv[n]);
+}
+
+////////////////////////////////////////////////////////////////////
+
+int TreeSpatialGrid::numChildren(int n) const
+{
+    int c = _childv[n];
+    if (c < 0) return 0;
+    int numSplits = (_xmaxv[c] < _xmaxv[n]) + (_ymaxv[c] < _ymaxv[n]) + (_zmaxv[c] < _zmaxv[n]);
+    return 1 << numSplits;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int TreeSpatialGrid::childNode(int n, Vec r) const
 {
-    return _nodev[0];
+    // the upper bounds of the first child equal those of the node, except along the axes where the node is split
+    int c = _childv[n];
+    int l = 0;
+    int bit = 1;
+    if (_xmaxv[c] < _xmaxv[n])
+    {
+        if (r.x() >= _xmaxv[c]) l += bit;
+        bit <<= 1;
+    }
+    if (_ymaxv[c] < _ymaxv[n])
+    {
+        if (r.y() >= _ymaxv[c]) l += bit;
+        bit <<= 1;
+    }
+    if (_zmaxv[c] < _zmaxv[n])
+    {
+        if (r.z() >= _zmaxv[c]) l += bit;
+    }
+    return c + l;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-TreeNode* TreeSpatialGrid::nodeForCellIndex(int m) const
+int TreeSpatialGrid::leafNode(Vec r) const
 {
-    return _nodev[_idv[m]];
+    if (!nodeContains(0, r)) return -1;
+
+    int n = 0;
+    while (_childv[n] >= 0) n = childNode(n, r);
+    return n;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-int TreeSpatialGrid::cellIndexForNode(const TreeNode* node) const
+int TreeSpatialGrid::neighborNode(int n, int wall, Vec r) const
 {
-    return _cellindexv[node->id()];
+    int end = _nbroffsetv[6 * n + wall + 1];
+    for (int i = _nbroffsetv[6 * n + wall]; i != end; ++i)
+    {
+        int neighbor = _nbrv[i];
+        if (nodeContains(neighbor, r)) return neighbor;
+    }
+    return -1;  // specified position is not inside any of the neighbors
 }
 
 ////////////////////////////////////////////////////////////////////
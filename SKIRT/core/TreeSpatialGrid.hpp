@@ -7,6 +7,7 @@
 #define TREESPATIALGRID_HPP
 
 #include "BoxSpatialGrid.hpp"
+class GridCache;
 class TextOutFile;
 class TreeNode;
 
@@ -23,7 +24,22 @@ class TreeNode;
     using the grid, such as calculating paths traversing the grid. Depending on the type of
     TreeNode, the tree can become an octtree (8 children per node) or a binary tree (2 children per
     node). Other node types could be implemented, as long as they are cuboids lined up with the
-    coordinate axes. */
+    coordinate axes.
+
+    The TreeNode objects are used only while constructing the tree. Once the tree is complete,
+    this class converts it to a frozen, pointer-free representation, and deletes the TreeNode
+    objects. In this flattened representation, each node is identified by its index in the list
+    returned by the subclass (the node ID). The node bounds are stored in six separate arrays
+    (structure of arrays), each nonleaf node holds the index of its first child (the children of a
+    node always have consecutive node IDs), and the neighbor lists for all nodes are packed into a
+    single array with an offset for each node wall (compressed sparse row format). This
+    drastically reduces the memory footprint per node for large trees, and it improves the memory
+    locality of the path traversal algorithm.
+
+    The flattened representation assumes that a nonleaf node is split into two halves along one
+    or more coordinate axes, and that its children are ordered with the x-axis varying fastest,
+    followed by the y-axis and then the z-axis, as is the case for the TreeNode subclasses offered
+    by SKIRT. This assumption is verified during setup. */
 class TreeSpatialGrid : public BoxSpatialGrid
 {
     ITEM_ABSTRACT(TreeSpatialGrid, BoxSpatialGrid, "a hierarchical tree spatial grid")
@@ -31,10 +47,6 @@ class TreeSpatialGrid : public BoxSpatialGrid
 
     //============= Construction - Setup - Destruction =============
 
-public:
-    /** The destructor deletes all tree nodes created during setup. */
-    ~TreeSpatialGrid();
-
 protected:
     /** This function invokes the constructTree() function, to be implemented by a subclass,
         causing the tree to be constructed. The subclass returns a list of all created nodes back
@@ -42,12 +54,19 @@ protected:
         this list. Ownership of the nodes resides in the list passed back to the base class (not in
         the subclass, and not in the node hierarchy itself).
 
-        After the subclass passes back the tree nodes, this function creates an extra vector that
-        contains the node IDs of all leaf nodes, i.e. all nodes corresponding to the actual spatial
-        cells. Conversely, the function also creates a vector with the cell indices of all the
-        nodes, i.e. the rank \f$m\f$ of the node in the ID vector if the node is a leaf, and the
-        number -1 if the node is not a leaf (and hence not a spatial cell). Finally, the function
-        logs some details on the number of cells in the tree. */
+        After the subclass passes back the tree nodes, this function converts the tree to the
+        flattened representation described in the class header, and deletes the TreeNode objects.
+        The function also creates a vector that contains the node IDs of all leaf nodes, i.e. all
+        nodes corresponding to the actual spatial cells. Conversely, the function creates a vector
+        with the cell indices of all the nodes, i.e. the rank \f$m\f$ of the node in the ID vector
+        if the node is a leaf, and the number -1 if the node is not a leaf (and hence not a spatial
+        cell). Finally, the function logs some details on the number of cells in the tree.
+
+        If spatial grid caching is enabled (see the GridCache class), the flattened representation
+        is stored in a cache file keyed on the configuration of the grid and the media (including
+        the complete contents of any imported files), the number of density samples, and the random
+        seed. If a matching cache file already exists, the flattened representation is loaded from
+        that file and the tree is not constructed at all. */
     void setupSelfAfter() override;
 
     /** This function must be implemented in a subclass. It constructs the hierarchical tree and
@@ -121,7 +140,10 @@ public:
         repeat this exercise. This loop is terminated when the next position is outside the grid.
 
         To determine the cell index of the "next cell" in this algorithm, the function uses the
-        neighbor lists constructed for each tree node during setup. */
+        neighbor lists constructed for each tree node during setup, as stored in the flattened
+        representation of the tree. If the next cell cannot be found among the neighbors, which may
+        happen on rare occasions due to rounding errors, the function falls back to a top-down
+        search starting at the root node. */
     std::unique_ptr<PathSegmentGenerator> createPathSegmentGenerator() const override;
 
     /** This function writes the topology of the tree to the specified text file in a simple,
@@ -152,28 +174,70 @@ protected:
     void write_xyz(SpatialGridPlotFile* outfile) const override;
 
 private:
-    /** This function returns a pointer to the root node of the tree. */
-    TreeNode* root() const;
-
-    /** This function returns a pointer to the node corresponding to cell index \f$m\f$. It just
-        reads the node ID of the \f$m\f$'th leaf cell from the precalculated ID vector and returns
-        the corresponding pointer of the tree vector. */
-    TreeNode* nodeForCellIndex(int m) const;
-
-    /** This function returns the cell index \f$m\f$ of a node in the tree. It just obtains the
-        node ID from the node and determines the corresponding cell index from the precalculated
-        cell index vector. */
-    int cellIndexForNode(const TreeNode* node) const;
+    /** This function converts the tree formed by the specified list of nodes to the flattened
+        representation described in the class header. It throws a fatal error if the tree does not
+        satisfy the assumptions of this representation. */
+    void flattenTree(const vector<TreeNode*>& nodev);
+
+    /** This function loads the flattened tree representation from the specified grid cache, which
+        must have been successfully loaded. */
+    void loadTree(const GridCache& cache);
+
+    /** This function stores the flattened tree representation in the specified grid cache, if
+        caching is enabled. */
+    void saveTree(GridCache& cache) const;
+
+    /** This function returns the spatial extent of the node with ID \f$n\f$. */
+    Box nodeExtent(int n) const;
+
+    /** This function returns true if the node with ID \f$n\f$ contains the position
+        \f${\bf{r}}\f$, and false otherwise. */
+    bool nodeContains(int n, Vec r) const
+    {
+        return r.x() >= _xminv[n] && r.x() <= _xmaxv[n] && r.y() >= _yminv[n] && r.y() <= _ymaxv[n]
+               && r.z() >= _zminv[n] && r.z() <= _zmaxv[n];
+    }
+
+    /** This function returns the number of children of the node with ID \f$n\f$, i.e. zero for a
+        leaf node, and two to the power of the number of coordinate axes along which the node is
+        split for a nonleaf node. */
+    int numChildren(int n) const;
+
+    /** This function returns the ID of the child of the nonleaf node with ID \f$n\f$ that
+        contains the position \f${\bf{r}}\f$, assuming that the position is inside the node. It
+        determines the split point of the node from the upper bounds of its first child. */
+    int childNode(int n, Vec r) const;
+
+    /** This function returns the ID of the leaf node that contains the position
+        \f${\bf{r}}\f$, or -1 if the position is outside of the grid. */
+    int leafNode(Vec r) const;
+
+    /** This function returns the ID of the node just beyond the given wall of the node with ID
+        \f$n\f$ that contains the position \f${\bf{r}}\f$, or -1 if such a node can't be found
+        by searching the neighbors of that wall. The wall is specified as a TreeNode::Wall value. */
+    int neighborNode(int n, int wall, Vec r) const;
+
+    /** This function writes a "0" for a leaf node or a "1" for a nonleaf node followed by the
+        recursive topological representation of its children. */
+    void writeTopologyForNode(int n, TextOutFile* outfile) const;
 
     //======================== Data Members ========================
 
 private:
     // data members initialized during setup
-    double _eps{0.};           // a small fraction relative to the spatial extent of the grid
-    vector<TreeNode*> _nodev;  // list of all nodes in the tree; holds ownership; first item is root node
-                               // node id in each node corresponds to index in this vector
-    vector<int> _cellindexv;   // cell index m corresponding to each node in nodev; -1 for nonleaf nodes
-    vector<int> _idv;          // node id (or equivalently, index in nodev) for each cell (i.e. leaf node)
+    double _eps{0.};  // a small fraction relative to the spatial extent of the grid
+
+    // flattened tree representation, indexed on node id (the root node has id zero)
+    vector<double> _xminv, _yminv, _zminv;  // lower node bounds
+    vector<double> _xmaxv, _ymaxv, _zmaxv;  // upper node bounds
+    vector<int> _childv;                    // node id of the first child for nonleaf nodes; -1 for leaf nodes
+    vector<int> _nbroffsetv;                // offset in nbrv of the neighbors at wall w of node n, at index 6*n+w
+    vector<int> _nbrv;                      // node ids of the neighbors for all nodes and walls
+
+    // translation between node ids and cell indices
+    vector<int> _cellindexv;        // cell index m corresponding to each node; -1 for nonleaf nodes
+    vector<int> _idv;               // node id for each cell (i.e. leaf node)
+    vector<unsigned char> _levelv;  // level in the tree hierarchy for each cell (i.e. leaf node)
 
     // allow our path segment generator to access our private data members
     class MySegmentGenerator;
@@ -4,8 +4,10 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "VoronoiMeshSnapshot.hpp"
+#include "Configuration.hpp"
 #include "EntityCollection.hpp"
 #include "FatalError.hpp"
+#include "GridCache.hpp"
 #include "Log.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
@@ -20,6 +22,8 @@
 #include "Table.hpp"
 #include "TextInFile.hpp"
 #include "Units.hpp"
+#include <atomic>
+#include <mutex>
 #include <set>
 #include "container.hh"
 
@@ -82,7 +86,7 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
-// class to hold the information about a Voronoi cell that is relevant for calculating paths and densities
+// class to hold the information about a Voronoi cell while the tessellation is being constructed
 class VoronoiMeshSnapshot::Cell : public Box  // enclosing box
 {
 private:
@@ -146,18 +150,12 @@ public:
         _neighbors.clear();
     }
 
-    // initializes the receiver with the volume calculated from imported information
-    void init(double volume) { _volume = volume; }
-
     // returns the cell's site position
     Vec position() const { return _r; }
 
     // returns the x coordinate of the cell's site position
     double x() const { return _r.x(); }
 
-    // returns the squared distance from the cell's site to the specified point
-    double squaredDistanceTo(Vec r) const { return (r - _r).norm2(); }
-
     // returns the central position in the cell
     Vec centroid() const { return _c; }
 
@@ -168,7 +166,7 @@ public:
     const vector<int>& neighbors() { return _neighbors; }
 
     // returns the cell/site user properties, if any
-    const Array& properties() { return _properties; }
+    Array& properties() { return _properties; }
 
     // writes the Voronoi cell geometry to the serialized data buffer, preceded by the specified cell index,
     // if the cell geometry has been calculated for this cell; otherwise does nothing
@@ -236,7 +234,7 @@ namespace
 class VoronoiMeshSnapshot::Node
 {
 private:
-    int _m;        // index in _cells to the site defining the split at this node
+    int _m;        // index in the site list to the site defining the split at this node
     int _axis;     // split axis for this node (0,1,2)
     Node* _up;     // ptr to the parent node
     Node* _left;   // ptr to the left child node
@@ -270,48 +268,67 @@ public:
     Node* right() const { return _right; }
 
     // returns the apropriate child for the specified query point
-    Node* child(Vec bfr, const vector<Cell*>& cells) const
+    Node* child(Vec bfr, const vector<Vec>& sites) const
     {
-        return lessthan(bfr, cells[_m]->position(), _axis) ? _left : _right;
+        return lessthan(bfr, sites[_m], _axis) ? _left : _right;
     }
 
     // returns the other child than the one that would be apropriate for the specified query point
-    Node* otherChild(Vec bfr, const vector<Cell*>& cells) const
+    Node* otherChild(Vec bfr, const vector<Vec>& sites) const
     {
-        return lessthan(bfr, cells[_m]->position(), _axis) ? _right : _left;
+        return lessthan(bfr, sites[_m], _axis) ? _right : _left;
     }
 
     // returns the squared distance from the query point to the split plane
-    double squaredDistanceToSplitPlane(Vec bfr, const vector<Cell*>& cells) const
+    double squaredDistanceToSplitPlane(Vec bfr, const vector<Vec>& sites) const
     {
         switch (_axis)
         {
             case 0:  // split on x
-                return sqr(cells[_m]->position().x() - bfr.x());
+                return sqr(sites[_m].x() - bfr.x());
             case 1:  // split on y
-                return sqr(cells[_m]->position().y() - bfr.y());
+                return sqr(sites[_m].y() - bfr.y());
             case 2:  // split on z
-                return sqr(cells[_m]->position().z() - bfr.z());
+                return sqr(sites[_m].z() - bfr.z());
             default:  // this should never happen
                 return 0;
         }
     }
 
+    // appends the site index and child flags of each node in this subtree to the specified vector, in preorder
+    void serialize(vector<int>& nodev) const
+    {
+        nodev.push_back(_m);
+        nodev.push_back((_left ? 1 : 0) | (_right ? 2 : 0));
+        if (_left) _left->serialize(nodev);
+        if (_right) _right->serialize(nodev);
+    }
+
+    // constructs a subtree from the preorder representation produced by serialize(), advancing the pointer
+    static Node* deserialize(const int*& current, int depth)
+    {
+        int m = *current++;
+        int flags = *current++;
+        Node* left = (flags & 1) ? deserialize(current, depth + 1) : nullptr;
+        Node* right = (flags & 2) ? deserialize(current, depth + 1) : nullptr;
+        return new Node(m, depth, left, right);
+    }
+
     // returns the node in this subtree that represents the site nearest to the query point
-    Node* nearest(Vec bfr, const vector<Cell*>& cells)
+    Node* nearest(Vec bfr, const vector<Vec>& sites)
     {
         // recursively descend the tree until a leaf node is reached, going left or right depending on
         // whether the specified point is less than or greater than the current node in the split dimension
         Node* current = this;
-        while (Node* child = current->child(bfr, cells)) current = child;
+        while (Node* child = current->child(bfr, sites)) current = child;
 
         // unwind the recursion, looking for the nearest node while climbing up
         Node* best = current;
-        double bestSD = cells[best->m()]->squaredDistanceTo(bfr);
+        double bestSD = (bfr - sites[best->m()]).norm2();
         while (true)
         {
             // if the current node is closer than the current best, then it becomes the current best
-            double currentSD = cells[current->m()]->squaredDistanceTo(bfr);
+            double currentSD = (bfr - sites[current->m()]).norm2();
             if (currentSD < bestSD)
             {
                 best = current;
@@ -320,16 +337,16 @@ public:
 
             // if there could be points on the other side of the splitting plane for the current node
             // that are closer to the search point than the current best, then ...
-            double splitSD = current->squaredDistanceToSplitPlane(bfr, cells);
+            double splitSD = current->squaredDistanceToSplitPlane(bfr, sites);
             if (splitSD < bestSD)
             {
                 // move down the other branch of the tree from the current node looking for closer points,
                 // following the same recursive process as the entire search
-                Node* other = current->otherChild(bfr, cells);
+                Node* other = current->otherChild(bfr, sites);
                 if (other)
                 {
-                    Node* otherBest = other->nearest(bfr, cells);
-                    double otherBestSD = cells[otherBest->m()]->squaredDistanceTo(bfr);
+                    Node* otherBest = other->nearest(bfr, sites);
+                    double otherBestSD = (bfr - sites[otherBest->m()]).norm2();
                     if (otherBestSD < bestSD)
                     {
                         best = otherBest;
@@ -383,6 +400,7 @@ void VoronoiMeshSnapshot::readAndClose()
     // if we forego building a Voronoi mesh, there is a density policy by definition
     else
     {
+        storeCells();
         calculateVolume();
         calculateDensityAndMass();
         buildSearchSingle();
@@ -485,6 +503,72 @@ namespace
         v.erase(to, v.end());
         return v.size();
     }
+
+    // pool of Voro++ cell calculators for a given container, so that a calculator can be reused by subsequent
+    // chunks of work in the same execution thread; constructing a calculator is relatively expensive because
+    // it allocates and clears a mask with an entry for each block in the container
+    template<class Cell> class VoroComputePool
+    {
+    private:
+        using Compute = voro::voro_compute<voro::container>;
+        voro::container& _vcon;
+        int _nb;
+        vector<size_t> _firstv;  // index of the first site in each block when sites are ordered by block
+        std::mutex _mutex;
+        vector<std::unique_ptr<Compute>> _available;
+
+    public:
+        VoroComputePool(voro::container& vcon, int nb) : _vcon(vcon), _nb(nb)
+        {
+            int nb3 = nb * nb * nb;
+            _firstv.resize(nb3 + 1);
+            for (int ijk = 0; ijk != nb3; ++ijk) _firstv[ijk + 1] = _firstv[ijk] + _vcon.co[ijk];
+        }
+
+        // computes the Voronoi cells for the sites with indices in the specified range, where the sites are ordered
+        // by container block, calling the specified function with the site index m and the computed cell for each
+        // site; distributing the work over sites rather than over blocks keeps the chunks balanced even if the
+        // sites are strongly clustered in a small fraction of the blocks
+        template<class Consumer> void compute(size_t firstSite, size_t numSites, Consumer consumer)
+        {
+            // obtain a calculator from the pool, or construct a new one if there is none available
+            std::unique_ptr<Compute> vcompute;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (!_available.empty())
+                {
+                    vcompute = std::move(_available.back());
+                    _available.pop_back();
+                }
+            }
+            if (!vcompute) vcompute = std::make_unique<Compute>(_vcon, _nb, _nb, _nb);
+
+            // locate the block holding the first site in the range
+            int ijk = std::upper_bound(_firstv.begin(), _firstv.end(), firstSite) - _firstv.begin() - 1;
+
+            // loop over the sites in the range, advancing to the next nonempty block as needed;
+            // Voro++ block indices have the x index varying fastest
+            Cell vcell;
+            size_t lastSite = min(firstSite + numSites, _firstv.back());
+            for (size_t site = firstSite; site < lastSite; ++ijk)
+            {
+                int k = ijk / (_nb * _nb);
+                int j = (ijk - k * _nb * _nb) / _nb;
+                int i = ijk - k * _nb * _nb - j * _nb;
+                size_t endSite = min(lastSite, _firstv[ijk + 1]);
+                for (; site < endSite; ++site)
+                {
+                    int q = site - _firstv[ijk];
+                    bool ok = vcompute->compute_cell(vcell, ijk, q, i, j, k);
+                    consumer(_vcon.id[ijk][q], ok, vcell);
+                }
+            }
+
+            // return the calculator to the pool
+            std::unique_lock<std::mutex> lock(_mutex);
+            _available.push_back(std::move(vcompute));
+        }
+    };
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -539,13 +623,45 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     }
 
     // abort if there are no cells to calculate
-    if (numCells <= 0) return;
+    if (numCells <= 0)
+    {
+        storeCells();
+        return;
+    }
 
     // calculate number of blocks in each direction based on number of cells
     _nb = max(3, min(250, static_cast<int>(cbrt(numCells))));
     _nb2 = _nb * _nb;
     _nb3 = _nb * _nb * _nb;
 
+    // ========= CACHING =========
+
+    // if caching is enabled, determine a cache key from the domain, the relaxation flag and the retained sites
+    _cacheKey = 0;
+    if (log()->find<Configuration>()->hasSpatialGridCache())
+    {
+        uint64_t key = GridCache::hash(GridCache::initialHash(), _extent);
+        key = GridCache::hash(key, relax);
+        for (auto cell : _cells) key = GridCache::hash(key, cell->position());
+        _cacheKey = key;
+    }
+
+    // load the tessellation from the cache, if possible
+    GridCache cache(log(), "voronoi", _cacheKey);
+    if (cache.load())
+    {
+        loadMesh(cache);
+        return;
+    }
+
+    // if the tessellation will be cached, keep track of the index in the list of retained sites for each cell
+    vector<int> indexv;
+    if (cache.isEnabled())
+    {
+        indexv.resize(numCells);
+        std::iota(indexv.begin(), indexv.end(), 0);
+    }
+
     // ========= RELAXATION =========
 
     // if requested, perform a single relaxation step
@@ -568,31 +684,19 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
         // and store the cell's centroid (relative to the site position) as the relaxation offset
         log()->info("Relaxing Voronoi tessellation with " + std::to_string(numCells) + " cells");
         log()->infoSetElapsed(numCells);
+        // distribute the work over the sites ordered by container block, so that nearby sites are handled together
+        VoroComputePool<voro::voronoicell> pool(vcon, _nb);
         auto parallel = log()->find<ParallelFactory>()->parallelDistributed();
-        parallel->call(numCells, [this, &vcon, &offsets](size_t firstIndex, size_t numIndices) {
-            // allocate a separate cell calculator for each thread to avoid conflicts
-            voro::voro_compute<voro::container> vcompute(vcon, _nb, _nb, _nb);
-            // allocate space for the resulting cell info
-            voro::voronoicell vcell;
-
-            // loop over all cells and work on the ones that have a particle index in our dedicated range
-            // (we cannot access cells in the container based on cell index m without building an extra data structure)
+        parallel->call(numCells, [this, &pool, &offsets](size_t firstIndex, size_t numIndices) {
             int numDone = 0;
-            voro::c_loop_all vloop(vcon);
-            if (vloop.start()) do
-                {
-                    size_t m = vloop.pid();
-                    if (m >= firstIndex && m < firstIndex + numIndices)
-                    {
-                        // compute the cell and store its centroid as relaxation offset
-                        bool ok = vcompute.compute_cell(vcell, vloop.ijk, vloop.q, vloop.i, vloop.j, vloop.k);
-                        if (ok) vcell.centroid(offsets(m, 0), offsets(m, 1), offsets(m, 2));
-
-                        // log message if the minimum time has elapsed
-                        numDone = (numDone + 1) % logProgressChunkSize;
-                        if (numDone == 0) log()->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
-                    }
-                } while (vloop.inc());
+            pool.compute(firstIndex, numIndices, [this, &offsets, &numDone](int m, bool ok, voro::voronoicell& vcell) {
+                // store the cell's centroid as relaxation offset
+                if (ok) vcell.centroid(offsets(m, 0), offsets(m, 1), offsets(m, 2));
+
+                // log message if the minimum time has elapsed
+                numDone = (numDone + 1) % logProgressChunkSize;
+                if (numDone == 0) log()->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
+            });
             if (numDone > 0) log()->infoIfElapsed("Computed Voronoi cells: ", numDone);
         });
 
@@ -621,31 +725,19 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
         //   - extract and copy the relevant information to the cell object with the corresponding index in our vector
         log()->info("Constructing Voronoi tessellation with " + std::to_string(numCells) + " cells");
         log()->infoSetElapsed(numCells);
+        // distribute the work over the sites ordered by container block, so that nearby sites are handled together
+        VoroComputePool<voro::voronoicell_neighbor> pool(vcon, _nb);
         auto parallel = log()->find<ParallelFactory>()->parallelDistributed();
-        parallel->call(numCells, [this, &vcon](size_t firstIndex, size_t numIndices) {
-            // allocate a separate cell calculator for each thread to avoid conflicts
-            voro::voro_compute<voro::container> vcompute(vcon, _nb, _nb, _nb);
-            // allocate space for the resulting cell info
-            voro::voronoicell_neighbor vcell;
-
-            // loop over all cells and work on the ones that have a particle index in our dedicated range
-            // (we cannot access cells in the container based on cell index m without building an extra data structure)
+        parallel->call(numCells, [this, &pool](size_t firstIndex, size_t numIndices) {
             int numDone = 0;
-            voro::c_loop_all vloop(vcon);
-            if (vloop.start()) do
-                {
-                    size_t m = vloop.pid();
-                    if (m >= firstIndex && m < firstIndex + numIndices)
-                    {
-                        // compute the cell and copy all relevant information to the cell object that will stay around
-                        bool ok = vcompute.compute_cell(vcell, vloop.ijk, vloop.q, vloop.i, vloop.j, vloop.k);
-                        if (ok) _cells[m]->init(vcell);
-
-                        // log message if the minimum time has elapsed
-                        numDone = (numDone + 1) % logProgressChunkSize;
-                        if (numDone == 0) log()->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
-                    }
-                } while (vloop.inc());
+            pool.compute(firstIndex, numIndices, [this, &numDone](int m, bool ok, voro::voronoicell_neighbor& vcell) {
+                // copy all relevant information to the cell object that will stay around
+                if (ok) _cells[m]->init(vcell);
+
+                // log message if the minimum time has elapsed
+                numDone = (numDone + 1) % logProgressChunkSize;
+                if (numDone == 0) log()->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
+            });
             if (numDone > 0) log()->infoIfElapsed("Computed Voronoi cells: ", numDone);
         });
 
@@ -667,22 +759,32 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
         // discover invalid cells with zero volume and/or with neighbors that are not mutual
         log()->info("Verifying Voronoi tessellation");
         std::set<int> invalid;
-        for (int m = 0; m < numCells; m++)
-        {
-            if (!_cells[m]->volume()) invalid.insert(m);
-            for (int m1 : _cells[m]->neighbors())
-            {
-                if (m1 >= 0)
+        std::mutex invalidMutex;
+        log()->find<ParallelFactory>()->parallelLocal()->call(
+            numCells, [this, &invalid, &invalidMutex](size_t firstIndex, size_t numIndices) {
+                std::set<int> chunkInvalid;
+                for (size_t m = firstIndex; m != firstIndex + numIndices; ++m)
                 {
-                    const vector<int>& neighbors1 = _cells[m1]->neighbors();
-                    if (std::find(neighbors1.begin(), neighbors1.end(), m) == neighbors1.end())
+                    if (!_cells[m]->volume()) chunkInvalid.insert(m);
+                    for (int m1 : _cells[m]->neighbors())
                     {
-                        invalid.insert(m);
-                        invalid.insert(m1);
+                        if (m1 >= 0)
+                        {
+                            const vector<int>& neighbors1 = _cells[m1]->neighbors();
+                            if (std::find(neighbors1.begin(), neighbors1.end(), m) == neighbors1.end())
+                            {
+                                chunkInvalid.insert(m);
+                                chunkInvalid.insert(m1);
+                            }
+                        }
                     }
                 }
-            }
-        }
+                if (!chunkInvalid.empty())
+                {
+                    std::unique_lock<std::mutex> lock(invalidMutex);
+                    invalid.insert(chunkInvalid.begin(), chunkInvalid.end());
+                }
+            });
 
         // break from loop if no invalid cells were found
         if (invalid.empty()) break;
@@ -703,8 +805,10 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
             int m = *it;
             delete _cells[m];
             _cells[m] = 0;
+            if (!indexv.empty()) indexv[m] = -1;
         }
         numCells = eraseNullPointers(_cells);
+        if (!indexv.empty()) indexv.erase(std::remove(indexv.begin(), indexv.end(), -1), indexv.end());
         for (int m = 0; m != numCells; ++m) _cells[m]->clear();
     }
 
@@ -728,18 +832,110 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     log()->info("  Average number of neighbors per cell: " + StringUtils::toString(avgNeighbors, 'f', 1));
     log()->info("  Minimum number of neighbors per cell: " + std::to_string(minNeighbors));
     log()->info("  Maximum number of neighbors per cell: " + std::to_string(maxNeighbors));
+
+    // copy the cell information into contiguous storage and release the cell objects
+    storeCells();
+
+    // store the tessellation in the cache, if enabled
+    if (cache.isEnabled())
+    {
+        cache.put("index", indexv);
+        cache.put("rv", _rv);
+        cache.put("cv", _cv);
+        cache.put("volume", _volumev);
+        cache.put("box", _boxv);
+        cache.put("nbroff", _nbroffsetv);
+        cache.put("nbr", _nbrv);
+        cache.save();
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
-void VoronoiMeshSnapshot::calculateVolume()
+void VoronoiMeshSnapshot::loadMesh(const GridCache& cache)
+{
+    // get the cell information
+    vector<int> indexv;
+    cache.get("index", indexv);
+    cache.get("rv", _rv);
+    cache.get("cv", _cv);
+    cache.get("volume", _volumev);
+    cache.get("box", _boxv);
+    cache.get("nbroff", _nbroffsetv);
+    cache.get("nbr", _nbrv);
+
+    // verify the consistency of the array sizes and indices
+    size_t numCells = indexv.size();
+    if (_rv.size() != numCells || _cv.size() != numCells || _volumev.size() != numCells || _boxv.size() != numCells
+        || _nbroffsetv.size() != numCells + 1 || _nbrv.size() != _nbroffsetv.back()
+        || std::any_of(indexv.begin(), indexv.end(),
+                       [this](int index) { return index < 0 || index >= static_cast<int>(_cells.size()); }))
+        throw FATALERROR("Inconsistent Voronoi tessellation data in cache file");
+
+    // move the user-defined properties, if any, from the retained sites to the corresponding cells
+    bool hasProperties = !_cells.empty() && _cells[0]->properties().size();
+    if (hasProperties)
+    {
+        _propv.resize(numCells);
+        for (size_t m = 0; m != numCells; ++m) _propv[m] = std::move(_cells[indexv[m]]->properties());
+    }
+
+    // release the cell objects
+    for (auto cell : _cells) delete cell;
+    _cells.clear();
+    _cells.shrink_to_fit();
+
+    log()->info("Done loading Voronoi tessellation with " + std::to_string(numCells) + " cells");
+}
+
+////////////////////////////////////////////////////////////////////
+
+void VoronoiMeshSnapshot::storeCells()
 {
     int numCells = _cells.size();
+    bool hasProperties = numCells && _cells[0]->properties().size();
+
+    // copy the site positions, centroids, volumes and bounding boxes, and move the user-defined properties, if any
+    _rv.resize(numCells);
+    _cv.resize(numCells);
+    _volumev.resize(numCells);
+    _boxv.resize(numCells);
+    if (hasProperties) _propv.resize(numCells);
+    _nbroffsetv.resize(numCells + 1);
+    size_t numNeighbors = 0;
     for (int m = 0; m != numCells; ++m)
     {
-        const Array& prop = _cells[m]->properties();
-        double volume = prop[densityIndex()] > 0. ? prop[massIndex()] / prop[densityIndex()] : 0.;
-        _cells[m]->init(volume);
+        _rv[m] = _cells[m]->position();
+        _cv[m] = _cells[m]->centroid();
+        _volumev[m] = _cells[m]->volume();
+        _boxv[m] = _cells[m]->extent();
+        if (hasProperties) _propv[m] = std::move(_cells[m]->properties());
+        _nbroffsetv[m] = numNeighbors;
+        numNeighbors += _cells[m]->neighbors().size();
+    }
+    _nbroffsetv[numCells] = numNeighbors;
+
+    // pack the neighbor lists into a single vector, releasing each cell object as soon as it has been copied
+    _nbrv.reserve(numNeighbors);
+    for (int m = 0; m != numCells; ++m)
+    {
+        const vector<int>& neighbors = _cells[m]->neighbors();
+        _nbrv.insert(_nbrv.end(), neighbors.begin(), neighbors.end());
+        delete _cells[m];
+    }
+    _cells.clear();
+    _cells.shrink_to_fit();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void VoronoiMeshSnapshot::calculateVolume()
+{
+    int numCells = _rv.size();
+    for (int m = 0; m != numCells; ++m)
+    {
+        const Array& prop = _propv[m];
+        _volumev[m] = prop[densityIndex()] > 0. ? prop[massIndex()] / prop[densityIndex()] : 0.;
     }
 }
 
@@ -748,7 +944,7 @@ void VoronoiMeshSnapshot::calculateVolume()
 void VoronoiMeshSnapshot::calculateDensityAndMass()
 {
     // allocate vectors for mass and density
-    int numCells = _cells.size();
+    int numCells = _rv.size();
     _rhov.resize(numCells);
     Array Mv(numCells);
 
@@ -764,7 +960,7 @@ void VoronoiMeshSnapshot::calculateDensityAndMass()
     int numIgnored = 0;
     for (int m = 0; m != numCells; ++m)
     {
-        const Array& prop = _cells[m]->properties();
+        const Array& prop = _propv[m];
 
         // original mass is zero if temperature is above cutoff or if imported mass/density is not positive
         double originalDensity = 0.;
@@ -775,7 +971,7 @@ void VoronoiMeshSnapshot::calculateDensityAndMass()
         }
         else
         {
-            double volume = _cells[m]->volume();
+            double volume = _volumev[m];
             originalDensity = max(0., densityIndex() >= 0 ? prop[densityIndex()] : prop[massIndex()] / volume);
             originalMass = max(0., massIndex() >= 0 ? prop[massIndex()] : prop[densityIndex()] * volume);
         }
@@ -812,7 +1008,7 @@ VoronoiMeshSnapshot::Node* VoronoiMeshSnapshot::buildTree(vector<int>::iterator
     {
         auto median = length >> 1;
         std::nth_element(first, first + median, last, [this, depth](int m1, int m2) {
-            return m1 != m2 && lessthan(_cells[m1]->position(), _cells[m2]->position(), depth % 3);
+            return m1 != m2 && lessthan(_rv[m1], _rv[m2], depth % 3);
         });
         return new VoronoiMeshSnapshot::Node(*(first + median), depth, buildTree(first, first + median, depth + 1),
                                              buildTree(first + median + 1, last, depth + 1));
@@ -825,25 +1021,71 @@ VoronoiMeshSnapshot::Node* VoronoiMeshSnapshot::buildTree(vector<int>::iterator
 void VoronoiMeshSnapshot::buildSearchPerBlock()
 {
     // abort if there are no cells
-    int numCells = _cells.size();
+    int numCells = _rv.size();
     if (!numCells) return;
 
     log()->info("Building data structures to accelerate searching the Voronoi tesselation");
 
-    // -------------  block lists  -------------
+    // load the search structures from the cache, if the tessellation is being cached and the cache file exists
+    // (the cache key of the tessellation also determines the search structures); otherwise build them
+    GridCache cache(log(), "voronoisearch", _cacheKey);
+    if (_cacheKey && cache.load())
+    {
+        loadSearchPerBlock(cache);
+    }
+    else
+    {
+        // -------------  block lists  -------------
+
+        // initialize a vector of nb x nb x nb lists, each containing the cells overlapping a certain block
+        _blocklists.resize(_nb3);
+
+        // calls the specified function for each block that a given cell may overlap
+        auto forEachBlock = [this](int m, std::function<void(int b)> process) {
+            int i1, j1, k1, i2, j2, k2;
+            _extent.cellIndices(i1, j1, k1, _boxv[m].rmin() - Vec(_eps, _eps, _eps), _nb, _nb, _nb);
+            _extent.cellIndices(i2, j2, k2, _boxv[m].rmax() + Vec(_eps, _eps, _eps), _nb, _nb, _nb);
+            for (int i = i1; i <= i2; i++)
+                for (int j = j1; j <= j2; j++)
+                    for (int k = k1; k <= k2; k++) process(i * _nb2 + j * _nb + k);
+        };
+
+        // add the cell index to the lists for all blocks it may overlap, in two parallel passes:
+        // first count the number of cells for each block, and then fill the preallocated lists
+        auto parallel = log()->find<ParallelFactory>()->parallelLocal();
+        vector<std::atomic<int>> counts(_nb3);
+        parallel->call(numCells, [&forEachBlock, &counts](size_t firstIndex, size_t numIndices) {
+            for (size_t m = firstIndex; m != firstIndex + numIndices; ++m)
+                forEachBlock(m, [&counts](int b) { counts[b].fetch_add(1, std::memory_order_relaxed); });
+        });
+        for (int b = 0; b < _nb3; b++)
+        {
+            _blocklists[b].resize(counts[b]);
+            counts[b] = 0;
+        }
+        parallel->call(numCells, [this, &forEachBlock, &counts](size_t firstIndex, size_t numIndices) {
+            for (size_t m = firstIndex; m != firstIndex + numIndices; ++m)
+                forEachBlock(m, [this, m, &counts](int b) {
+                    _blocklists[b][counts[b].fetch_add(1, std::memory_order_relaxed)] = m;
+                });
+        });
 
-    // initialize a vector of nb x nb x nb lists, each containing the cells overlapping a certain block in the domain
-    _blocklists.resize(_nb3);
+        // -------------  search trees  -------------
 
-    // add the cell object to the lists for all blocks it may overlap
-    int i1, j1, k1, i2, j2, k2;
-    for (int m = 0; m != numCells; ++m)
-    {
-        _extent.cellIndices(i1, j1, k1, _cells[m]->rmin() - Vec(_eps, _eps, _eps), _nb, _nb, _nb);
-        _extent.cellIndices(i2, j2, k2, _cells[m]->rmax() + Vec(_eps, _eps, _eps), _nb, _nb, _nb);
-        for (int i = i1; i <= i2; i++)
-            for (int j = j1; j <= j2; j++)
-                for (int k = k1; k <= k2; k++) _blocklists[i * _nb2 + j * _nb + k].push_back(m);
+        // for each block, sort the cell indices (the parallel fill above leaves them in arbitrary order) and, if
+        // the block contains more than a predefined number of cells, construct a search tree on the site locations
+        _blocktrees.resize(_nb3);
+        parallel->call(_nb3, [this](size_t firstIndex, size_t numIndices) {
+            for (size_t b = firstIndex; b != firstIndex + numIndices; ++b)
+            {
+                vector<int>& ids = _blocklists[b];
+                std::sort(ids.begin(), ids.end());
+                if (ids.size() > 9) _blocktrees[b] = buildTree(ids.begin(), ids.end(), 0);
+            }
+        });
+
+        // store the search structures in the cache, if enabled
+        if (_cacheKey) saveSearchPerBlock(cache);
     }
 
     // compile block list statistics
@@ -865,17 +1107,6 @@ void VoronoiMeshSnapshot::buildSearchPerBlock()
     log()->info("  Minimum number of cells per block: " + std::to_string(minRefsPerBlock));
     log()->info("  Maximum number of cells per block: " + std::to_string(maxRefsPerBlock));
 
-    // -------------  search trees  -------------
-
-    // for each block that contains more than a predefined number of cells,
-    // construct a search tree on the site locations of the cells
-    _blocktrees.resize(_nb3);
-    for (int b = 0; b < _nb3; b++)
-    {
-        vector<int>& ids = _blocklists[b];
-        if (ids.size() > 9) _blocktrees[b] = buildTree(ids.begin(), ids.end(), 0);
-    }
-
     // compile and log search tree statistics
     int numTrees = 0;
     for (int b = 0; b < _nb3; b++)
@@ -886,10 +1117,71 @@ void VoronoiMeshSnapshot::buildSearchPerBlock()
 
 ////////////////////////////////////////////////////////////////////
 
+void VoronoiMeshSnapshot::loadSearchPerBlock(const GridCache& cache)
+{
+    // get the block lists, packed into a single vector with an offset for each block
+    vector<size_t> listoffsetv;
+    vector<int> listv;
+    cache.get("listoff", listoffsetv);
+    cache.get("list", listv);
+    if (listoffsetv.size() != static_cast<size_t>(_nb3) + 1 || listv.size() != listoffsetv.back())
+        throw FATALERROR("Inconsistent Voronoi search data in cache file");
+    _blocklists.resize(_nb3);
+    for (int b = 0; b != _nb3; ++b)
+        _blocklists[b].assign(listv.begin() + listoffsetv[b], listv.begin() + listoffsetv[b + 1]);
+
+    // get the search trees, each serialized in preorder, packed into a single vector with an offset for each block
+    vector<size_t> treeoffsetv;
+    vector<int> treev;
+    cache.get("treeoff", treeoffsetv);
+    cache.get("tree", treev);
+    if (treeoffsetv.size() != static_cast<size_t>(_nb3) + 1 || treev.size() != treeoffsetv.back())
+        throw FATALERROR("Inconsistent Voronoi search data in cache file");
+    _blocktrees.resize(_nb3);
+    for (int b = 0; b != _nb3; ++b)
+    {
+        if (treeoffsetv[b + 1] > treeoffsetv[b])
+        {
+            const int* current = treev.data() + treeoffsetv[b];
+            _blocktrees[b] = Node::deserialize(current, 0);
+            if (current != treev.data() + treeoffsetv[b + 1])
+                throw FATALERROR("Inconsistent Voronoi search data in cache file");
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void VoronoiMeshSnapshot::saveSearchPerBlock(GridCache& cache) const
+{
+    // pack the block lists and the serialized search trees into single vectors with an offset for each block
+    vector<size_t> listoffsetv(_nb3 + 1);
+    vector<int> listv;
+    vector<size_t> treeoffsetv(_nb3 + 1);
+    vector<int> treev;
+    for (int b = 0; b != _nb3; ++b)
+    {
+        listoffsetv[b] = listv.size();
+        listv.insert(listv.end(), _blocklists[b].begin(), _blocklists[b].end());
+        treeoffsetv[b] = treev.size();
+        if (_blocktrees[b]) _blocktrees[b]->serialize(treev);
+    }
+    listoffsetv[_nb3] = listv.size();
+    treeoffsetv[_nb3] = treev.size();
+
+    cache.put("listoff", listoffsetv);
+    cache.put("list", listv);
+    cache.put("treeoff", treeoffsetv);
+    cache.put("tree", treev);
+    cache.save();
+}
+
+////////////////////////////////////////////////////////////////////
+
 void VoronoiMeshSnapshot::buildSearchSingle()
 {
     // log the number of sites
-    int numCells = _cells.size();
+    int numCells = _rv.size();
     log()->info("  Number of sites: " + std::to_string(numCells));
 
     // abort if there are no cells
@@ -905,12 +1197,13 @@ void VoronoiMeshSnapshot::buildSearchSingle()
 
 ////////////////////////////////////////////////////////////////////
 
-bool VoronoiMeshSnapshot::isPointClosestTo(Vec r, int m, const vector<int>& ids) const
+bool VoronoiMeshSnapshot::isPointClosestTo(Vec r, int m) const
 {
-    double target = _cells[m]->squaredDistanceTo(r);
-    for (int id : ids)
+    double target = (r - _rv[m]).norm2();
+    for (size_t i = _nbroffsetv[m]; i != _nbroffsetv[m + 1]; ++i)
     {
-        if (id >= 0 && _cells[id]->squaredDistanceTo(r) < target) return false;
+        int id = _nbrv[i];
+        if (id >= 0 && (r - _rv[id]).norm2() < target) return false;
     }
     return true;
 }
@@ -926,12 +1219,12 @@ void VoronoiMeshSnapshot::writeGridPlotFiles(const SimulationItem* probe) const
     SpatialGridPlotFile plotxyz(probe, probe->itemName() + "_grid_xyz");
 
     // load all sites in a Voro container
-    int numCells = _cells.size();
+    int numCells = _rv.size();
     voro::container vcon(_extent.xmin(), _extent.xmax(), _extent.ymin(), _extent.ymax(), _extent.zmin(), _extent.zmax(),
                          _nb, _nb, _nb, false, false, false, 16);
     for (int m = 0; m != numCells; ++m)
     {
-        Vec r = _cells[m]->position();
+        Vec r = _rv[m];
         vcon.put(m, r.x(), r.y(), r.z());
     }
 
@@ -955,7 +1248,7 @@ void VoronoiMeshSnapshot::writeGridPlotFiles(const SimulationItem* probe) const
             vcell.face_vertices(indices);
 
             // write the edges of the cell to the plot files
-            Box bounds = _cells[vloop.pid()]->extent();
+            const Box& bounds = _boxv[vloop.pid()];
             if (bounds.zmin() <= 0 && bounds.zmax() >= 0) plotxy.writePolyhedron(coords, indices);
             if (bounds.ymin() <= 0 && bounds.ymax() >= 0) plotxz.writePolyhedron(coords, indices);
             if (bounds.xmin() <= 0 && bounds.xmax() >= 0) plotyz.writePolyhedron(coords, indices);
@@ -978,35 +1271,35 @@ Box VoronoiMeshSnapshot::extent() const
 
 int VoronoiMeshSnapshot::numEntities() const
 {
-    return _cells.size();
+    return _rv.size();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position VoronoiMeshSnapshot::position(int m) const
 {
-    return Position(_cells[m]->position());
+    return Position(_rv[m]);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position VoronoiMeshSnapshot::centroidPosition(int m) const
 {
-    return Position(_cells[m]->centroid());
+    return Position(_cv[m]);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double VoronoiMeshSnapshot::volume(int m) const
 {
-    return _cells[m]->volume();
+    return _volumev[m];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Box VoronoiMeshSnapshot::extent(int m) const
 {
-    return _cells[m]->extent();
+    return _boxv[m];
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1036,14 +1329,13 @@ double VoronoiMeshSnapshot::mass() const
 Position VoronoiMeshSnapshot::generatePosition(int m) const
 {
     // get loop-invariant information about the cell
-    const Box& box = _cells[m]->extent();
-    const vector<int>& neighbors = _cells[m]->neighbors();
+    const Box& box = _boxv[m];
 
     // generate random points in the enclosing box until one happens to be inside the cell
     for (int i = 0; i < 10000; i++)
     {
         Position r = random()->position(box);
-        if (isPointClosestTo(r, m, neighbors)) return r;
+        if (isPointClosestTo(r, m)) return r;
     }
     throw FATALERROR("Can't find random position in cell");
 }
@@ -1053,7 +1345,7 @@ Position VoronoiMeshSnapshot::generatePosition(int m) const
 Position VoronoiMeshSnapshot::generatePosition() const
 {
     // if there are no sites, return the origin
-    if (_cells.empty()) return Position();
+    if (_rv.empty()) return Position();
 
     // select a site according to its mass contribution
     int m = NR::locateClip(_cumrhov, random()->uniform());
@@ -1080,7 +1372,7 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
 
     // look for the closest site in this block, using the search tree if there is one
     Node* tree = _blocktrees[b];
-    if (tree) return tree->nearest(bfr, _cells)->m();
+    if (tree) return tree->nearest(bfr, _rv)->m();
 
     // if there is no search tree, simply loop over the index list
     const vector<int>& ids = _blocklists[b];
@@ -1089,7 +1381,7 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
     int n = ids.size();
     for (int i = 0; i < n; i++)
     {
-        double idist = _cells[ids[i]]->squaredDistanceTo(bfr);
+        double idist = (bfr - _rv[ids[i]]).norm2();
         if (idist < mdist)
         {
             m = ids[i];
@@ -1103,7 +1395,7 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
 
 const Array& VoronoiMeshSnapshot::properties(int m) const
 {
-    return _cells[m]->properties();
+    return _propv[m];
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1154,7 +1446,7 @@ public:
                 while (true)
                 {
                     // get the site position for this cell
-                    Vec pr = _grid->_cells[_mr]->position();
+                    Vec pr = _grid->_rv[_mr];
 
                     // initialize the smallest nonnegative intersection distance and corresponding index
                     double sq = DBL_MAX;  // very large, but not infinity (so that infinite si values are discarded)
@@ -1162,9 +1454,9 @@ public:
                     int mq = NO_INDEX;
 
                     // loop over the list of neighbor indices
-                    const vector<int>& mv = _grid->_cells[_mr]->neighbors();
-                    int n = mv.size();
-                    for (int i = 0; i < n; i++)
+                    const int* mv = _grid->_nbrv.data();
+                    size_t end = _grid->_nbroffsetv[_mr + 1];
+                    for (size_t i = _grid->_nbroffsetv[_mr]; i != end; ++i)
                     {
                         int mi = mv[i];
 
@@ -1175,7 +1467,7 @@ public:
                         if (mi >= 0)
                         {
                             // get the site position for this neighbor
-                            Vec pi = _grid->_cells[mi]->position();
+                            Vec pi = _grid->_rv[mi];
 
                             // calculate the (unnormalized) normal on the bisecting plane
                             Vec n = pi - pr;
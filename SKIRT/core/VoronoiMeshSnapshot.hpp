@@ -8,6 +8,7 @@
 
 #include "Array.hpp"
 #include "Snapshot.hpp"
+class GridCache;
 class PathSegmentGenerator;
 class SiteListInterface;
 class SpatialGridPath;
@@ -184,8 +185,8 @@ public:
     //=========== Private construction ==========
 
 private:
-    /** Private class to hold the information about a Voronoi cell that is relevant for calculating
-        paths and densities; see the buildMesh() function. */
+    /** Private class to hold the information about a Voronoi cell while the tessellation is being
+        constructed; see the buildMesh() and storeCells() functions. */
     class Cell;
 
     /** Private class to hold a node in the internal binary search tree; see the buildTree()
@@ -201,6 +202,17 @@ private:
         information (such as the list of neighboring cells) from the Voro++ data structures into
         its own.
 
+        The work is distributed over parallel execution threads and processes by spatial block of
+        the Voro++ container, so that each chunk of work directly addresses the sites in a region of
+        the domain rather than scanning all sites. Voro++ cell calculators, which each allocate a
+        mask with an entry for every block, are pooled and reused by subsequent chunks.
+
+        If spatial grid caching is enabled (see the GridCache class), the resulting cell
+        information is stored in a cache file keyed on the domain extent, the relaxation flag and
+        the positions of the sites retained for the tessellation. If a matching cache file already
+        exists, the cell information is loaded from that file and the tessellation is not
+        constructed at all.
+
         If the \em relax argument is true, the function performs a single relaxation step on the
         site positions using Lloyd's algorithm (Lloyd 1982; Du, Faber and Gunzburger 1999, SIAM
         review 41.4, pp 637-676; Dobbels 2017, master thesis). An intermediate Voronoi tessellation
@@ -211,6 +223,22 @@ private:
         quite time-consuming because the Voronoi tessellation must be constructed twice. */
     void buildMesh(bool relax);
 
+    /** This private function loads the cell information produced by buildMesh() from the
+        specified grid cache, which must have been successfully loaded, and moves the user-defined
+        properties of the corresponding retained sites into place. */
+    void loadMesh(const GridCache& cache);
+
+    /** This private function copies the cell information that is relevant for calculating paths
+        and densities from the temporary Cell objects into contiguous storage, and releases the
+        Cell objects. The site positions, centroids, volumes, bounding boxes and user-defined
+        properties are each stored in a separate vector indexed on cell index, and the neighbor
+        lists for all cells are packed into a single vector with an offset for each cell
+        (compressed sparse row format). As a result, the path segment generator streams through
+        the neighbor indices of a cell in a single memory block, and the per-cell memory overhead
+        of separate heap allocations is avoided. The function is called at the end of buildMesh(),
+        or before calculating the cell volumes if the Voronoi mesh is not built. */
+    void storeCells();
+
     /** This private function calculates the volumes for all cells without using the Voronoi mesh.
         It assumes that both mass and mass density columns are being imported. */
     void calculateVolume();
@@ -239,9 +267,27 @@ private:
 
         To further reduce the search time within blocks that overlap with a large number of cells,
         the function builds a binary search tree on the cell sites for those blocks (see for example
-        <a href="http://en.wikipedia.org/wiki/Kd-tree">en.wikipedia.org/wiki/Kd-tree</a>). */
+        <a href="http://en.wikipedia.org/wiki/Kd-tree">en.wikipedia.org/wiki/Kd-tree</a>).
+
+        The block lists are filled in parallel in two passes over the cells (counting and then
+        storing), after which the lists are sorted and the search trees are built in parallel over
+        the blocks. Sorting the lists guarantees that the result does not depend on the number of
+        execution threads.
+
+        If the tessellation is being cached, the block lists and search trees are cached as well,
+        using the same cache key. */
     void buildSearchPerBlock();
 
+    /** This private function loads the block lists and search trees produced by
+        buildSearchPerBlock() from the specified grid cache, which must have been successfully
+        loaded. */
+    void loadSearchPerBlock(const GridCache& cache);
+
+    /** This private function stores the block lists and search trees produced by
+        buildSearchPerBlock() in the specified grid cache. Each search tree is serialized as a
+        sequence of nodes in preorder. */
+    void saveSearchPerBlock(GridCache& cache) const;
+
     /** This private function builds a data structure that allows accelerating the operation of the
         cellIndex() function without using the Voronoi mesh. The domain is not partitioned in
         blocks. The function builds a single binary search tree on all cell sites (see for example
@@ -249,8 +295,8 @@ private:
     void buildSearchSingle();
 
     /** This private function returns true if the given point is closer to the site with index m
-        than to the sites with indices ids. */
-    bool isPointClosestTo(Vec r, int m, const vector<int>& ids) const;
+        than to the sites of the neighbors of the cell with index m. */
+    bool isPointClosestTo(Vec r, int m) const;
 
     //====================== Output =====================
 
@@ -455,9 +501,20 @@ private:
     double _eps{0.};                 // small fraction of extent
     bool _foregoVoronoiMesh{false};  // true if using search tree instead of Voronoi tessellation
 
-    // data members initialized when processing snapshot input and further completed by BuildMesh()
+    // data members initialized when processing snapshot input and further completed by BuildMesh();
+    // the cell objects are released by storeCells() after copying the relevant information to the vectors below
     vector<Cell*> _cells;  // cell objects, indexed on m
 
+    // data members initialized by storeCells(), indexed on m
+    vector<Vec> _rv;             // site position for each cell
+    vector<Vec> _cv;             // centroid position for each cell
+    vector<double> _volumev;     // volume for each cell
+    vector<Box> _boxv;           // enclosing box for each cell
+    vector<Array> _propv;        // user-defined properties for each cell, if any
+    vector<size_t> _nbroffsetv;  // offset in nbrv of the neighbor list for each cell, plus a final entry
+    vector<int> _nbrv;           // neighbor indices (or negative domain wall indices) for all cells
+    uint64_t _cacheKey{0};       // key for caching the tessellation and search structures, or zero if not cached
+
     // data members initialized when processing snapshot input, but only if a density policy has been set
     Array _rhov;       // density for each cell (not normalized)
     Array _cumrhov;    // normalized cumulative density distribution for cells
@@ -39,12 +39,62 @@
     covered by the band's transmission curve.
 
     Finally, and most importantly, the public interface offers a function to determine the (indices
-    of) the bin(s) that may have a nonzero transmission at a given wavelength. */
+    of) the bin(s) that may have a nonzero transmission at a given wavelength. Because this
+    function is called for every detected photon packet, it stores its result in a BinList
+    instance provided by the caller, which avoids heap allocations in all but exceptional cases. */
 class WavelengthGrid : public SimulationItem
 {
     ITEM_ABSTRACT(WavelengthGrid, SimulationItem, "a wavelength grid")
     ITEM_END()
 
+    //======================== Bin list =======================
+
+public:
+    /** A BinList instance holds a short list of wavelength bin indices, as returned by the
+        WavelengthGrid::bins() function. The list can hold up to BinList::N indices without
+        performing heap allocations; this capacity suffices for all but the most exotic sets of
+        overlapping bins. If the list does become longer than N, the indices are moved to a
+        heap-allocated buffer. The list can be iterated over using a range-based for loop. */
+    class BinList
+    {
+    public:
+        const static int N = 8;
+
+        /** This function removes all indices from the list. */
+        void clear()
+        {
+            _n = 0;
+            _v.clear();
+        }
+
+        /** This function adds the specified index to the list. */
+        void add(int ell)
+        {
+            if (_n < N)
+                _a[_n] = ell;
+            else
+            {
+                if (_n == N) _v.assign(_a, _a + N);
+                _v.push_back(ell);
+            }
+            _n++;
+        }
+
+        /** This function returns the number of indices in the list. */
+        int size() const { return _n; }
+
+        /** This function returns an iterator to the first index in the list. */
+        const int* begin() const { return _n <= N ? _a : _v.data(); }
+
+        /** This function returns an iterator just beyond the last index in the list. */
+        const int* end() const { return begin() + _n; }
+
+    private:
+        int _n{0};       // the number of indices in the list
+        int _a[N];       // the inside buffer, used if the list holds at most N indices
+        vector<int> _v;  // the heap-allocated buffer, used if the list holds more than N indices
+    };
+
     //======================== Public interface =======================
 
 public:
@@ -85,11 +135,12 @@ public:
         the transmission at that wavelength divided by the maximum transmission for the bin. */
     virtual double transmission(int ell, double lambda) const = 0;
 
-    /** This function returns a list of indices \f$\ell_k\f$ of the wavelength bins that may have a
-        nonzero transmission at the specified wavelength \f$\lambda\f$, i.e. for which
-        \f$\lambda^\mathrm{left}_\ell \le \lambda \le \lambda^\mathrm{right}_\ell\f$. If no
-        wavelengths bins match this condition, the function returns an empty list. */
-    virtual vector<int> bins(double lambda) const = 0;
+    /** This function stores in the specified list the indices \f$\ell_k\f$ of the wavelength bins
+        that may have a nonzero transmission at the specified wavelength \f$\lambda\f$, i.e. for
+        which \f$\lambda^\mathrm{left}_\ell \le \lambda \le \lambda^\mathrm{right}_\ell\f$. Any
+        previous contents of the list is removed. If no wavelengths bins match this condition, the
+        list is left empty. */
+    virtual void bins(double lambda, BinList& ellv) const = 0;
 
     /** This function returns the index \f$\ell\f$ of one the wavelength bins that may have a
         nonzero transmission at the specified wavelength \f$\lambda\f$, i.e. for which
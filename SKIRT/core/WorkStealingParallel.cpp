@@ -0,0 +1,133 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "WorkStealingParallel.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the number of chunks into which each initial subrange is divided
+    const size_t numChunksPerThread = 8;
+}
+
+////////////////////////////////////////////////////////////////////
+
+WorkStealingParallel::WorkStealingParallel(int threadCount) : _queues(threadCount)
+{
+    constructThreads(threadCount);
+}
+
+////////////////////////////////////////////////////////////////////
+
+WorkStealingParallel::~WorkStealingParallel()
+{
+    destroyThreads();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void WorkStealingParallel::call(size_t maxIndex, std::function<void(size_t, size_t)> target)
+{
+    // Copy the target function so it can be invoked from any of the threads
+    _target = target;
+
+    // Divide the index range in contiguous subranges, one for each thread
+    size_t numQueues = _queues.size();
+    for (size_t t = 0; t != numQueues; ++t)
+    {
+        Queue& queue = _queues[t];
+        queue.begin = maxIndex * t / numQueues;
+        queue.end = maxIndex * (t + 1) / numQueues;
+        queue.chunkSize = max(static_cast<size_t>(1), (queue.end - queue.begin) / numChunksPerThread);
+    }
+
+    // Activate child threads and wait until they are done; we don't do anything in the parent thread
+    activateThreads();
+    waitForThreads();
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool WorkStealingParallel::doSomeWork(int threadIndex)
+{
+    size_t firstIndex, numIndices;
+    if (!takeChunk(threadIndex, firstIndex, numIndices))
+    {
+        if (!steal(threadIndex) || !takeChunk(threadIndex, firstIndex, numIndices)) return false;
+    }
+    _target(firstIndex, numIndices);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool WorkStealingParallel::takeChunk(int threadIndex, size_t& firstIndex, size_t& numIndices)
+{
+    Queue& queue = _queues[threadIndex];
+    std::unique_lock<std::mutex> lock(queue.mutex);
+
+    size_t remaining = queue.end - queue.begin;
+    if (!remaining) return false;
+
+    // halve the chunk size as the remaining work decreases, so that chunks become smaller near the end
+    while (queue.chunkSize > 1 && 2 * queue.chunkSize > remaining) queue.chunkSize /= 2;
+
+    firstIndex = queue.begin;
+    numIndices = min(queue.chunkSize, remaining);
+    queue.begin += numIndices;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool WorkStealingParallel::steal(int threadIndex)
+{
+    int numQueues = _queues.size();
+    while (true)
+    {
+        // find the victim with the largest remaining subrange
+        int victim = -1;
+        size_t largest = 0;
+        for (int t = 0; t != numQueues; ++t)
+        {
+            if (t != threadIndex)
+            {
+                Queue& queue = _queues[t];
+                std::unique_lock<std::mutex> lock(queue.mutex);
+                size_t remaining = queue.end - queue.begin;
+                if (remaining > largest)
+                {
+                    largest = remaining;
+                    victim = t;
+                }
+            }
+        }
+        if (victim < 0) return false;
+
+        // steal the back half of the victim's subrange (or the single remaining index)
+        size_t begin, end;
+        {
+            Queue& queue = _queues[victim];
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            size_t remaining = queue.end - queue.begin;
+            if (!remaining) continue;  // the victim consumed its work in the meantime; try again
+            size_t stolen = max(static_cast<size_t>(1), remaining / 2);
+            end = queue.end;
+            begin = end - stolen;
+            queue.end = begin;
+        }
+
+        // install the stolen range as our own subrange
+        Queue& queue = _queues[threadIndex];
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.begin = begin;
+        queue.end = end;
+        queue.chunkSize = max(static_cast<size_t>(1), (end - begin) / numChunksPerThread);
+        return true;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,89 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef WORKSTEALINGPARALLEL_HPP
+#define WORKSTEALINGPARALLEL_HPP
+
+#include "MultiParallel.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** This class implements the Parallel base class interface using multiple execution threads in a
+    single process, distributing the work through a work-stealing scheduler. It uses the facilities
+    offered by the MultiParallel base class.
+
+    At the start of each call, the index range is split into contiguous subranges of equal size,
+    one for each thread. Each thread consumes chunks from the front of its own subrange. The size
+    of these chunks starts at one eighth of the initial subrange and is halved as the remaining
+    work in the subrange decreases, so that the chunks become smaller towards the end of the call.
+    When a thread has exhausted its own subrange, it steals the back half of the largest remaining
+    subrange of any other thread, and continues consuming chunks from the stolen range.
+
+    Compared to the MultiThreadParallel class, which hands out fixed-size chunks from a single
+    shared counter, this scheme offers better load balancing when the cost per index varies
+    substantially (e.g., for photon packets that are launched into regions with very different
+    optical depths) because the chunks handed out near the end of the call are much smaller. In
+    addition, the threads mostly access their own subrange, limiting contention on shared data.
+
+    Each subrange is protected by its own mutex. The owning thread and any thieves hold the lock
+    for just a few instructions, so that contention remains very limited. */
+class WorkStealingParallel : public MultiParallel
+{
+    friend class ParallelFactory;  // so ParallelFactory can access our private constructor
+
+    //============= Construction - Destruction =============
+
+private:
+    /** Constructs a WorkStealingParallel instance with the specified number of execution threads.
+        The constructor is private; use the ParallelFactory::parallel() function instead. */
+    explicit WorkStealingParallel(int threadCount);
+
+public:
+    /** Destructs the instance and its parallel threads. */
+    ~WorkStealingParallel();
+
+    //======================== Other Functions =======================
+
+public:
+    /** This function implements the call() interface described in the Parallel base class for the
+        parallelization scheme offered by this subclass. */
+    void call(size_t maxIndex, std::function<void(size_t firstIndex, size_t numIndices)> target) override;
+
+protected:
+    /** The function to do the actual work, one chunk at a time. The function takes a chunk from
+        the subrange owned by the calling thread, or if that subrange is empty, steals half of the
+        largest remaining subrange from another thread. */
+    bool doSomeWork(int threadIndex) override;
+
+private:
+    /** This function takes the next chunk from the subrange owned by the specified thread, and
+        returns true if successful or false if the subrange is empty. */
+    bool takeChunk(int threadIndex, size_t& firstIndex, size_t& numIndices);
+
+    /** This function steals the back half of the largest subrange owned by any other thread and
+        installs it as the subrange owned by the specified thread. It returns true if successful or
+        false if there is no more work to be stolen. */
+    bool steal(int threadIndex);
+
+    //======================== Data Members ========================
+
+private:
+    // the subrange of indices owned by a thread, padded to avoid false sharing between threads
+    struct Queue
+    {
+        std::mutex mutex;      // the mutex protecting this subrange
+        size_t begin{0};       // the first index in the subrange
+        size_t end{0};         // the index beyond the last index in the subrange
+        size_t chunkSize{1};   // the current chunk size
+        char padding[64]{};    // padding to keep the subranges of different threads on different cache lines
+    };
+
+    std::function<void(size_t, size_t)> _target;  // the target function to be called
+    std::vector<Queue> _queues;                   // the subrange for each thread
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -20,7 +20,7 @@ result in a ski file, without actually performing the simulation. Otherwise, it
 simulations in the ski files specified on the command line according to the following syntax:
 
 \verbatim
- skirt [-t <threads>] [-s <simulations>] [-d]
+ skirt [-t <threads>] [-s <simulations>] [-d] [-w]
        [-b] [-v] [-m] [-e]
        [-k] [-i <dirpath>] [-o <dirpath>]
        [-r] {<filepath>}*
@@ -33,6 +33,11 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -d option enables data parallelization mode for multiple processes.
 
+- The -w option enables work-stealing scheduling for the parallel threads in each process. Rather than handing out
+  chunks of fixed size from a shared pool, each thread then consumes chunks of decreasing size from its own range of
+  tasks and steals work from other threads when its own range is exhausted. This may improve load balancing for
+  simulations in which the cost of individual photon packets varies substantially.
+
 - The -b option forces brief console logging, i.e. only success and error messages are shown rather than all progress
   messages. If there are multiple parallel simulations (see the -s option), the -b option is turned on automatically
   to avoid a plethora of randomly intermixing messages. If there is only one simulation at a time, the console shows
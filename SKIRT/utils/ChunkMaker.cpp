@@ -11,11 +11,25 @@ ChunkMaker::ChunkMaker() {}
 
 //////////////////////////////////////////////////////////////////////
 
-void ChunkMaker::initialize(size_t maxIndex, int numThreads, int numProcs)
+void ChunkMaker::initialize(size_t maxIndex, int numThreads, int numProcs, bool guided)
 {
     // Determine the chunk size
     const size_t numChunksPerThread = 8;  // empirical multiplicator to achieve acceptable load balancing
-    _chunkSize = max(static_cast<size_t>(1), maxIndex / (numThreads * numProcs * numChunksPerThread));
+    size_t numWorkers = numThreads * numProcs;
+    _chunkSize = max(static_cast<size_t>(1), maxIndex / (numWorkers * numChunksPerThread));
+
+    // In guided mode, each chunk receives a fraction of the remaining indices proportional to the number of
+    // workers, with a minimum size that limits the total number of chunks to a multiple of the static case
+    if (guided)
+    {
+        const size_t minimumDivider = 8;  // empirical ratio between the static and the minimum guided chunk size
+        _chunkSize = max(static_cast<size_t>(1), _chunkSize / minimumDivider);
+        _divisor = 2 * numWorkers;
+    }
+    else
+    {
+        _divisor = 0;
+    }
 
     // Initialize the other data members
     _maxIndex = maxIndex;
@@ -24,29 +38,47 @@ void ChunkMaker::initialize(size_t maxIndex, int numThreads, int numProcs)
 
 //////////////////////////////////////////////////////////////////////
 
-bool ChunkMaker::next(size_t& firstIndex, size_t& numIndices)
+bool ChunkMaker::take(size_t& firstIndex, size_t& numIndices)
 {
-    size_t first = _nextIndex.fetch_add(_chunkSize);
-    if (first < _maxIndex)
+    // in static mode, a single atomic addition suffices
+    if (!_divisor)
     {
+        size_t first = _nextIndex.fetch_add(_chunkSize);
+        if (first >= _maxIndex) return false;
         firstIndex = first;
         numIndices = min(_chunkSize, _maxIndex - first);
         return true;
     }
-    return false;
+
+    // in guided mode, the chunk size depends on the current position, so we need a compare-and-swap loop
+    size_t first = _nextIndex.load();
+    size_t num = 0;
+    do
+    {
+        if (first >= _maxIndex) return false;
+        size_t remaining = _maxIndex - first;
+        num = min(remaining, max(_chunkSize, remaining / _divisor));
+    } while (!_nextIndex.compare_exchange_weak(first, first + num));
+    firstIndex = first;
+    numIndices = num;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool ChunkMaker::next(size_t& firstIndex, size_t& numIndices)
+{
+    return take(firstIndex, numIndices);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 bool ChunkMaker::callForNext(const std::function<void(size_t, size_t)>& target)
 {
-    size_t first = _nextIndex.fetch_add(_chunkSize);
-    if (first < _maxIndex)
-    {
-        target(first, min(_chunkSize, _maxIndex - first));
-        return true;
-    }
-    return false;
+    size_t firstIndex, numIndices;
+    if (!take(firstIndex, numIndices)) return false;
+    target(firstIndex, numIndices);
+    return true;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -20,7 +20,14 @@
     chunk and the number of indices in the chunk, and it is expected to iterate over the specified
     index range. The chunk sizes are determined by the heuristic in the ChunkMaker object to
     achieve optimal load balancing given the available parallel resources, while still maximally
-    reducing the overhead of handing out the chunks. */
+    reducing the overhead of handing out the chunks.
+
+    The ChunkMaker class supports two heuristics. In static mode, all chunks have the same size,
+    determined from the number of indices and the number of available threads and processes. In
+    guided mode, the size of each chunk is proportional to the number of indices that remain to be
+    handed out, so that the chunks become smaller as the work runs out. This reduces the time that
+    some threads or processes spend waiting for others to finish when the cost per index varies
+    substantially, while keeping the number of chunks (and thus the overhead) limited. */
 class ChunkMaker
 {
 public:
@@ -29,8 +36,9 @@ public:
 
     /** This function initializes the ChunkMaker object to the specified range (from zero to
         \f$N-1\f$), using the specified number of threads and processes to help determine an
-        appropriate chunk size. */
-    void initialize(size_t maxIndex, int numThreads, int numProcs = 1);
+        appropriate chunk size. If the \em guided flag is true, the chunk sizes decrease as the
+        remaining number of indices decreases; otherwise all chunks have the same size. */
+    void initialize(size_t maxIndex, int numThreads, int numProcs = 1, bool guided = false);
 
     /** This function gets the next chunk, in the form of the first index and the number of indices
         in the chunk. If a chunk is still available, the function places a chunk index range in its
@@ -48,7 +56,16 @@ public:
     bool callForNext(const std::function<void(size_t firstIndex, size_t numIndices)>& target);
 
 private:
-    size_t _chunkSize{0};               // the number of indices in all but the last chunk
+    /** This function obtains the next chunk for both the next() and callForNext() functions. If a
+        chunk is still available, the function places a chunk index range in its arguments and
+        returns true. Otherwise the function returns false. */
+    bool take(size_t& firstIndex, size_t& numIndices);
+
+private:
+    size_t _chunkSize{0};               // the number of indices in all but the last chunk (static mode)
+                                        // ... or the minimum number of indices in a chunk (guided mode)
+    size_t _divisor{0};                 // the divisor applied to the remaining number of indices, or zero
+                                        // ... for static mode
     size_t _maxIndex{0};                // the maximum index (i.e. limiting the last chunk)
     std::atomic<size_t> _nextIndex{0};  // the first index of the next available chunk
 };
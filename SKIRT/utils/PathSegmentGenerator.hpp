@@ -60,7 +60,7 @@ public:
 
     /** This function calculates the next path segment and stores its cell index and path length in
         data members that can be accessed through the m() and ds() functions. It should be called
-        only after the path has been intialized through the start() function. The next() function
+        only after the path has been initialized through the start() function. The next() function
         returns true if a path segment is available and false if there are no more segments in the
         path. In the latter case, the values returned by the m() and ds() functions are undefined.
 
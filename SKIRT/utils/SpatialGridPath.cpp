@@ -18,22 +18,27 @@ namespace
 
 SpatialGridPath::SpatialGridPath(const Position& bfr, const Direction& bfk) : _bfr(bfr), _bfk(bfk)
 {
-    _segments.reserve(INITIAL_CAPACITY);
+    _mv.reserve(INITIAL_CAPACITY);
+    _dsv.reserve(INITIAL_CAPACITY);
+    _tauv.reserve(INITIAL_CAPACITY);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 SpatialGridPath::SpatialGridPath()
 {
-    _segments.reserve(INITIAL_CAPACITY);
+    _mv.reserve(INITIAL_CAPACITY);
+    _dsv.reserve(INITIAL_CAPACITY);
+    _tauv.reserve(INITIAL_CAPACITY);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void SpatialGridPath::clear()
 {
-    _segments.clear();
-    _s = 0.;
+    _mv.clear();
+    _dsv.clear();
+    clearOpticalDepths();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -42,13 +47,21 @@ void SpatialGridPath::addSegment(int m, double ds)
 {
     if (ds > 0.)
     {
-        _s += ds;
-        _segments.emplace_back(m, ds, _s);
+        _mv.push_back(m);
+        _dsv.push_back(ds);
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+void SpatialGridPath::clearOpticalDepths()
+{
+    _tauv.clear();
+    _tauAbsv.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
 Position SpatialGridPath::moveInside(const Box& box, double eps)
 {
     // a position that is certainly not inside any box
@@ -156,7 +169,7 @@ Position SpatialGridPath::moveInside(const Box& box, double eps)
 
 double SpatialGridPath::totalOpticalDepth() const
 {
-    return !_segments.empty() ? _segments.back().tauExtOrSca() : 0.;
+    return !_tauv.empty() ? _tauv.back() : 0.;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -164,7 +177,7 @@ double SpatialGridPath::totalOpticalDepth() const
 void SpatialGridPath::findInteractionPoint(double tauinteract)
 {
     // we can't handle an empty path
-    if (_segments.empty())
+    if (_tauv.empty())
     {
         _interactionCellIndex = -1;
         _interactionDistance = 0.;
@@ -172,35 +185,34 @@ void SpatialGridPath::findInteractionPoint(double tauinteract)
     }
     else
     {
-        // find a pointer to the first segment that has an exit optical depth strictly larger than the given value,
-        // (so that we never select an empty segment) or a pointer beyond the list if no such element is found
-        auto seg = std::upper_bound(_segments.cbegin(), _segments.cend(), tauinteract,
-                                    [](double t, const Segment& seg) { return t < seg.tauExtOrSca(); });
+        // find the index of the first segment that has an exit optical depth strictly larger than the given value,
+        // (so that we never select an empty segment) or the number of segments if no such element is found
+        size_t numSegments = _tauv.size();
+        size_t i = std::upper_bound(_tauv.cbegin(), _tauv.cend(), tauinteract) - _tauv.cbegin();
 
-        // if we find the first segment, interpolate with the path's entry point
-        if (seg == _segments.cbegin())
-        {
-            _interactionCellIndex = seg->m();
-            _interactionDistance = NR::interpolateLinLin(tauinteract, 0., seg->tauExtOrSca(), 0., seg->s());
-            _interactionOpticalDepth = NR::interpolateLinLin(tauinteract, 0., seg->tauExtOrSca(), 0., seg->tauAbs());
-        }
+        // if we are precisely at or beyond the exit optical depth of the last segment, just use the last segment
+        bool beyond = i == numSegments;
+        if (beyond) i--;
 
-        // if we find some other segment, interpolate with the previous segment
-        else if (seg < _segments.cend())
+        // calculate the cumulative distance at the entry and exit of the segment
+        double s0 = 0.;
+        for (size_t j = 0; j != i; ++j) s0 += _dsv[j];
+        double s1 = s0 + _dsv[i];
+
+        _interactionCellIndex = _mv[i];
+        if (beyond)
         {
-            _interactionCellIndex = seg->m();
-            _interactionDistance = NR::interpolateLinLin(tauinteract, (seg - 1)->tauExtOrSca(), seg->tauExtOrSca(),
-                                                         (seg - 1)->s(), seg->s());
-            _interactionOpticalDepth = NR::interpolateLinLin(tauinteract, (seg - 1)->tauExtOrSca(), seg->tauExtOrSca(),
-                                                             (seg - 1)->tauAbs(), seg->tauAbs());
+            _interactionDistance = s1;
+            _interactionOpticalDepth = tauAbs(i);
         }
 
-        // if we are precisely at or beyond the exit optical depth of the last segment, just use the last segment
+        // otherwise interpolate with the previous segment, or with the path's entry point for the first segment
         else
         {
-            _interactionCellIndex = (seg - 1)->m();
-            _interactionDistance = (seg - 1)->s();
-            _interactionOpticalDepth = (seg - 1)->tauAbs();
+            double tau0 = i ? _tauv[i - 1] : 0.;
+            double tauAbs0 = i ? tauAbs(i - 1) : 0.;
+            _interactionDistance = NR::interpolateLinLin(tauinteract, tau0, _tauv[i], s0, s1);
+            _interactionOpticalDepth = NR::interpolateLinLin(tauinteract, tau0, _tauv[i], tauAbs0, tauAbs(i));
         }
     }
 }
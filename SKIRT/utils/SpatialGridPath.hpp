@@ -16,9 +16,8 @@ class Box;
     a spatial grid, i.e. some partition of space into cells, a starting position \f${\bf{r}}\f$ and
     a propagation direction \f${\bf{k}}\f$, one can calculate the path through the grid. A
     SpatialGridPath object maintains a record for each cell crossed by the path, called a \em
-    segment. A segment stores the spatial cell index (so the cell can be identified in the grid),
-    together with the physical path length \f$\Delta s\f$ covered within the cell, and the path
-    length \f$s\f$ covered along the entire path up to the end of the cell.
+    segment. A segment stores the spatial cell index (so the cell can be identified in the grid)
+    and the physical path length \f$\Delta s\f$ covered within the cell.
 
     Updating the initial position and/or the direction of the path invalidates all segments in the
     path, but the segments are not automatically cleared. One should call the clear() function or
@@ -31,7 +30,14 @@ class Box;
     explicit absorption) or both a scattering and absorption optical depth (for forced-scattering
     photon life cycles \em with explicit absorption). The interaction point information includes
     the spatial cell index, the cumulative distance, and the cumulative absorption optical depth
-    (for the second type of photon cycle). */
+    (for the second type of photon cycle).
+
+    Because a path is recalculated for every forced-scattering step, and paths through large
+    spatial grids may cross many thousands of cells, the segment information is stored in compact
+    form as a structure of arrays: the cell indices, the segment lengths, and the optical depths
+    are kept in separate arrays, and the absorption optical depths are stored only if the client
+    code provides them. Cumulative distances along the path are not stored but recalculated when
+    needed. */
 class SpatialGridPath
 {
 public:
@@ -84,43 +90,53 @@ public:
 
     // ------- Working with path segments -------
 
-    /** This data structure holds information about a given segment in the path. In addition to the
-        spatial information (cell index, incremental distance, cumulative distance) managed by the
-        SpatialGridPath class itself, segments can also store optical depth information managed by
-        client code for forced-scattering photon life cycles. For photon life cycles \em without
-        explicit absorption, just the extinction optical depth is stored. For life cycles \em with
-        explicit absorption, the scattering and absorption optical depth are stored separately. */
-    class Segment
+    /** This function returns the number of segments in the path. */
+    size_t numSegments() const { return _mv.size(); }
+
+    /** This function returns the spatial cell index for the segment with index \f$i\f$, or -1 if
+        the segment is outside of the grid. */
+    int m(size_t i) const { return _mv[i]; }
+
+    /** This function returns the distance \f$\Delta s\f$ covered within the cell for the segment
+        with index \f$i\f$. The cumulative distance along the path is not stored; client code
+        iterating over the segments should accumulate the segment lengths itself. */
+    double ds(size_t i) const { return _dsv[i]; }
+
+    // ------- Working with optical depths -------
+
+    /** This function removes any optical depth information from the path, without touching the
+        geometric information. It must be called before adding optical depth information to a path
+        that already has such information. */
+    void clearOpticalDepths();
+
+    /** This function adds the cumulative extinction optical depth at the exit of the next segment
+        for forced-scattering photon life cycles \em without explicit absorption. The optical
+        depths must be added in the order of the segments, after all segments have been added. */
+    void addOpticalDepth(double tauExt) { _tauv.push_back(tauExt); }
+
+    /** This function adds the cumulative scattering and absorption optical depths at the exit of
+        the next segment for forced-scattering photon life cycles \em with explicit absorption.
+        The optical depths must be added in the order of the segments, after all segments have been
+        added. */
+    void addOpticalDepth(double tauSca, double tauAbs)
     {
-        int _m;               // cell index
-        double _ds;           // distance within the cell
-        double _s;            // cumulative distance until cell exit
-        double _tauExtOrSca;  // cumulative extinction or scattering optical depth at cell exit
-        double _tauAbs;       // cumulative absorption optical depth at cell exit or zero
-    public:
-        Segment(int m, double ds, double s) : _m(m), _ds(ds), _s(s), _tauExtOrSca{0.}, _tauAbs{0.} {}
-        int m() const { return _m; }
-        double ds() const { return _ds; }
-        double s() const { return _s; }
-        double tauExtOrSca() const { return _tauExtOrSca; }
-        double tauAbs() const { return _tauAbs; }
-        double tauExt() const { return _tauExtOrSca + _tauAbs; }
-        void setOpticalDepth(double tauExt) { _tauExtOrSca = tauExt; }
-        void setOpticalDepth(double tauSca, double tauAbs)
-        {
-            _tauExtOrSca = tauSca;
-            _tauAbs = tauAbs;
-        }
-    };
-
-    /** This function returns a read-only reference to the list of the current segments in the
-        path. */
-    const vector<Segment>& segments() const { return _segments; }
+        _tauv.push_back(tauSca);
+        _tauAbsv.push_back(tauAbs);
+    }
+
+    /** This function returns the cumulative extinction or scattering optical depth at the exit of
+        the segment with index \f$i\f$, depending on which one has been stored by the client code.
+        */
+    double tauExtOrSca(size_t i) const { return _tauv[i]; }
+
+    /** This function returns the cumulative absorption optical depth at the exit of the segment
+        with index \f$i\f$, or zero if no absorption optical depths have been stored. */
+    double tauAbs(size_t i) const { return _tauAbsv.empty() ? 0. : _tauAbsv[i]; }
 
-    /** This function returns a writable reference to the list of the current segments in the path.
-        Because the segments are writable, the client code can update the stored optical depth
-        information. */
-    vector<Segment>& segments() { return _segments; }
+    /** This function returns the cumulative extinction optical depth at the exit of the segment
+        with index \f$i\f$, i.e. the sum of the scattering and absorption optical depths if these
+        have been stored separately. */
+    double tauExt(size_t i) const { return _tauAbsv.empty() ? _tauv[i] : _tauv[i] + _tauAbsv[i]; }
 
     // ------- Handling the interaction point -------
 
@@ -181,8 +197,10 @@ public:
 private:
     Position _bfr;
     Direction _bfk;
-    vector<Segment> _segments;
-    double _s{0.};
+    vector<int> _mv;          // cell index for each segment
+    vector<double> _dsv;      // distance within the cell for each segment
+    vector<double> _tauv;     // cumulative extinction or scattering optical depth at each segment exit, if stored
+    vector<double> _tauAbsv;  // cumulative absorption optical depth at each segment exit, if stored
     int _interactionCellIndex{-1};
     double _interactionDistance{0.};
     double _interactionOpticalDepth{0.};